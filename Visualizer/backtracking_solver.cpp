@@ -7,8 +7,18 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cassert>
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "backtracking_solver.h"
+#include "canonical.h"
+#include "solver.h"
+#include "dlx.h"
 #include "matrix.h"
+#include "step_solver.h"
+#include "thread_pool.h"
 
 #define DIM 9
 #define BOX_DIM 3
@@ -184,8 +194,9 @@ struct coordinate get_empty_posn(int grid[DIM + 1][DIM + 1],
 
 
 
-// sudoku_solver_wrapper(grid, curr_row, curr_column) returns true and solves the given
-// grid if it can be solved and returns false otherwise
+// wrapper_search(grid, curr_row, curr_column, depth, counter) is
+// sudoku_solver_wrapper(grid, curr_row, curr_column) with depth cells already filled in
+// by the search, reporting to counter, which may halt it
 
 // effects: may mutate grid
 
@@ -193,14 +204,22 @@ struct coordinate get_empty_posn(int grid[DIM + 1][DIM + 1],
 //           curr_row and curr_column must be valid indexes
 
 // time: O()
-bool sudoku_solver_wrapper(int grid[DIM + 1][DIM + 1], int curr_row, int curr_column){
+template <class COUNTER>
+static bool wrapper_search(int grid[DIM + 1][DIM + 1], int curr_row, int curr_column,
+                           int depth, COUNTER &counter){
   assert(grid);
   assert(curr_row >= 0);
   assert(curr_row < DIM);
   assert(curr_column >= 0);
   assert(curr_column < DIM);
 
+  counter.node(depth);
+  if(counter.halt()){
+    return false;
+  }
+  std::uint64_t since = counter.start();
   struct coordinate empty_posn = get_empty_posn(grid, curr_row, curr_column);
+  counter.selected(since);
 
   if(coordinates_equal(empty_posn, GRID_FULL)){
     return true;
@@ -209,12 +228,17 @@ bool sudoku_solver_wrapper(int grid[DIM + 1][DIM + 1], int curr_row, int curr_co
   const int row = empty_posn.row;
   const int col = empty_posn.column;
   for(int num = 1; num <= DIM; ++num){
-    if(is_valid(grid, row, col, num)){
+    since = counter.start();
+    const bool valid = is_valid(grid, row, col, num);
+    counter.checked(since);
+    if(valid){
       grid[row][col] = num;
-      if(sudoku_solver_wrapper(grid, row, col)){
+      counter.guessed();
+      if(wrapper_search(grid, row, col, depth + 1, counter)){
         return true;
       }
       grid[row][col] = 0;
+      counter.undone(1);
     }
   }
   return false;
@@ -222,6 +246,42 @@ bool sudoku_solver_wrapper(int grid[DIM + 1][DIM + 1], int curr_row, int curr_co
 
 
 
+// sudoku_solver_wrapper(grid, curr_row, curr_column) returns true and solves the given
+// grid if it can be solved and returns false otherwise
+
+// effects: may mutate grid
+
+// requires: grid must not be NULL
+//           curr_row and curr_column must be valid indexes
+
+// time: O()
+bool sudoku_solver_wrapper(int grid[DIM + 1][DIM + 1], int curr_row, int curr_column){
+  sudoku::no_counter counter(NULL);
+  return wrapper_search(grid, curr_row, curr_column, 0, counter);
+}
+
+
+
+// sudoku_solver_wrapper(grid, curr_row, curr_column, stats) is
+// sudoku_solver_wrapper(grid, curr_row, curr_column) that also clears stats and fills it
+// in: get_empty_posn() counts as selection and is_valid() as checking
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+//           curr_row and curr_column must be valid indexes
+
+// time: O()
+bool sudoku_solver_wrapper(int grid[DIM + 1][DIM + 1], int curr_row, int curr_column,
+                           sudoku::search_stats *stats){
+  assert(stats);
+  stats->clear();
+  sudoku::search_counter counter(stats);
+  return wrapper_search(grid, curr_row, curr_column, 0, counter);
+}
+
+
+
 // sudoku_solver(grid) returns true and solves the given grid if it can be solved and returns
 // false otherwise
 
@@ -229,8 +289,483 @@ bool sudoku_solver_wrapper(int grid[DIM + 1][DIM + 1], int curr_row, int curr_co
 
 // requires: grid must not be NULL, and grid must be incomplete
 
+// note: runs on sudoku::solver<BOX_DIM> (bitmasks, singles propagation and MRV
+//       branching) rather than the is_valid() scans above, which are kept as the
+//       plain reference implementation
+
 // time: O()
 bool sudoku_solver(int grid[DIM + 1][DIM + 1]){
   assert(grid);
-  return sudoku_solver_wrapper(grid, 0, 0);
+  int cells[DIM * DIM];
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    cells[cell] = grid[cell / DIM][cell % DIM];
+  }
+  static thread_local sudoku::solver<BOX_DIM> board;
+  if(!board.load(cells) || !board.solve()){
+    return false;
+  }
+  board.store(cells);
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    grid[cell / DIM][cell % DIM] = cells[cell];
+  }
+  return true;
+}
+
+
+
+// sudoku_solver(grid, stats) is sudoku_solver(grid) that also clears stats and fills it
+// in (see solver::solve(stats))
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+
+// time: O()
+bool sudoku_solver(int grid[DIM + 1][DIM + 1], sudoku::search_stats *stats){
+  assert(grid);
+  assert(stats);
+  int cells[DIM * DIM];
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    cells[cell] = grid[cell / DIM][cell % DIM];
+  }
+  static thread_local sudoku::solver<BOX_DIM> board;
+  if(!board.load(cells)){
+    stats->clear();
+    return false;
+  }
+  if(!board.solve(stats)){
+    return false;
+  }
+  board.store(cells);
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    grid[cell / DIM][cell % DIM] = cells[cell];
+  }
+  return true;
+}
+
+
+
+// sudoku_solver(grid, options, stats) is sudoku_solver(grid, stats) within the budget
+// of options (see solve_options.h): it returns SOLVE_SOLVED with the grid solved,
+// SOLVE_UNSOLVABLE, or SOLVE_EXHAUSTED with the grid unchanged if the budget ran out
+// first, with stats counting the search up to then
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+
+// time: O()
+sudoku::solve_result sudoku_solver(int grid[DIM + 1][DIM + 1], const sudoku::solve_options &options,
+                                   sudoku::search_stats *stats){
+  assert(grid);
+  assert(stats);
+  int cells[DIM * DIM];
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    cells[cell] = grid[cell / DIM][cell % DIM];
+  }
+  static thread_local sudoku::solver<BOX_DIM> board;
+  board.load(cells);
+  const sudoku::solve_result result = board.solve(options, stats);
+  if(result == sudoku::SOLVE_SOLVED){
+    board.store(cells);
+    for(int cell = 0; cell < DIM * DIM; ++cell){
+      grid[cell / DIM][cell % DIM] = cells[cell];
+    }
+  }
+  return result;
+}
+
+
+
+// clues_consistent(grid) returns true if no number of grid clashes with another in its
+// row, column or box. sudoku_solver_wrapper() only checks the numbers it places itself
+
+// requires: grid must not be NULL
+
+// time: O(n^3) where n is DIM
+static bool clues_consistent(int grid[DIM + 1][DIM + 1]){
+  for(int row = 0; row < DIM; ++row){
+    for(int col = 0; col < DIM; ++col){
+      const int num = grid[row][col];
+      if(num){
+        grid[row][col] = 0;
+        const bool valid = num > 0 && num <= DIM && is_valid(grid, row, col, num);
+        grid[row][col] = num;
+        if(!valid){
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+
+
+// sudoku_solver(grid, cache) is sudoku_solver(grid) answered from cache when it can be
+
+// effects: may mutate grid and cache
+
+// requires: grid and cache must not be NULL
+
+// time: O()
+bool sudoku_solver(int grid[DIM + 1][DIM + 1], sudoku::solution_cache *cache){
+  assert(grid);
+  assert(cache);
+  int cells[DIM * DIM];
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    const int num = grid[cell / DIM][cell % DIM];
+    if(num < 0 || num > DIM){
+      return false;
+    }
+    cells[cell] = num;
+  }
+  if(!cache->solve(cells)){
+    return false;
+  }
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    grid[cell / DIM][cell % DIM] = cells[cell];
+  }
+  return true;
+}
+
+
+
+// matrix_seed() returns a new seed for each thread's ENGINE_RANDOM_ORDER matrix, so that
+// no two threads search in the same random orders
+static std::uint64_t matrix_seed(){
+  static std::atomic<std::uint64_t> made(0);
+  return made.fetch_add(1, std::memory_order_relaxed);
+}
+
+
+
+// sudoku_solver(grid, engine) is sudoku_solver(grid) run on the chosen engine:
+// ENGINE_BITMASK is the sudoku::solver search, ENGINE_DLX the exact cover search
+// in sudoku::dlx, ENGINE_ROW_MAJOR the get_empty_posn() and is_valid() search of
+// sudoku_solver_wrapper() and ENGINE_RANDOM_ORDER matrix::solve_dfs()
+
+// effects: may mutate grid
+
+// requires: grid must not be NULL
+
+// time: O()
+bool sudoku_solver(int grid[DIM + 1][DIM + 1], enum solver_engine engine){
+  assert(grid);
+  if(engine == ENGINE_DLX){
+    static thread_local sudoku::dlx links(BOX_DIM);
+    return links.solve(grid);
+  }
+  if(engine == ENGINE_ROW_MAJOR){
+    return clues_consistent(grid) && sudoku_solver_wrapper(grid, 0, 0);
+  }
+  if(engine == ENGINE_RANDOM_ORDER){
+    static thread_local sudoku::matrix board(matrix_seed());
+    board.input(grid);
+    if(!board.solve_dfs()){
+      return false;
+    }
+    board.output(grid);
+    return true;
+  }
+  return sudoku_solver(grid);
+}
+
+
+
+// sudoku_solver(grid, engine, options, stats) is sudoku_solver(grid, engine) within the
+// budget of options, like sudoku_solver(grid, options, stats)
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+
+// time: O()
+sudoku::solve_result sudoku_solver(int grid[DIM + 1][DIM + 1], enum solver_engine engine,
+                                   const sudoku::solve_options &options,
+                                   sudoku::search_stats *stats){
+  assert(grid);
+  assert(stats);
+  if(engine == ENGINE_DLX){
+    static thread_local sudoku::dlx links(BOX_DIM);
+    int cells[DIM * DIM];
+    for(int cell = 0; cell < DIM * DIM; ++cell){
+      cells[cell] = grid[cell / DIM][cell % DIM];
+    }
+    const sudoku::solve_result result = links.solve(cells, options, stats);
+    if(result == sudoku::SOLVE_SOLVED){
+      for(int cell = 0; cell < DIM * DIM; ++cell){
+        grid[cell / DIM][cell % DIM] = cells[cell];
+      }
+    }
+    return result;
+  }
+  if(engine == ENGINE_ROW_MAJOR){
+    stats->clear();
+    if(!clues_consistent(grid)){
+      return sudoku::SOLVE_UNSOLVABLE;
+    }
+    sudoku::budget_counter counter(stats, options);
+    const bool solved = wrapper_search(grid, 0, 0, 0, counter);
+    stats->nodes = counter.nodes_searched();
+    return solved ? sudoku::SOLVE_SOLVED : counter.halted() ? sudoku::SOLVE_EXHAUSTED :
+                                                              sudoku::SOLVE_UNSOLVABLE;
+  }
+  if(engine == ENGINE_RANDOM_ORDER){
+    static thread_local sudoku::matrix board(matrix_seed());
+    board.input(grid);
+    const sudoku::solve_result result = board.solve_dfs(options, stats);
+    if(result == sudoku::SOLVE_SOLVED){
+      board.output(grid);
+    }
+    return result;
+  }
+  return sudoku_solver(grid, options, stats);
+}
+
+
+
+// step_within(search, options, stop) runs search a slice of options.check_interval nodes
+// at a time until it is solved or shown unsolvable, has searched options.max_nodes nodes
+// since load(), has passed options.deadline, or options.cancelled(), and returns how it
+// ended
+
+// effects: mutates search
+static sudoku::solve_result step_within(sudoku::step_solver<BOX_DIM> &search,
+                                        const sudoku::solve_options &options){
+  for(;;){
+    const sudoku::step_status status = search.status();
+    if(status == sudoku::STEP_SOLVED || status == sudoku::STEP_UNSOLVABLE){
+      return status == sudoku::STEP_SOLVED ? sudoku::SOLVE_SOLVED : sudoku::SOLVE_UNSOLVABLE;
+    }
+    const long left = options.max_nodes ? options.max_nodes - search.nodes() : options.check_interval;
+    if(left <= 0 || options.cancelled() || sudoku::solve_options::clock::now() >= options.deadline){
+      return sudoku::SOLVE_EXHAUSTED;
+    }
+    search.step(left < options.check_interval ? left : options.check_interval);
+  }
+}
+
+// step_result(search, result, grid, stats) fills in stats with the nodes and guesses of
+// search and, if result is SOLVE_SOLVED, grid with its board
+
+// effects: mutates grid and stats
+static void step_result(const sudoku::step_solver<BOX_DIM> &search, sudoku::solve_result result,
+                        int grid[DIM + 1][DIM + 1], sudoku::search_stats *stats){
+  stats->clear();
+  stats->nodes = search.nodes();
+  stats->guesses = search.guesses();
+  if(result == sudoku::SOLVE_SOLVED){
+    for(int cell = 0; cell < DIM * DIM; ++cell){
+      grid[cell / DIM][cell % DIM] = search.board_state().read(cell);
+    }
+  }
+}
+
+
+
+// sudoku_solver_race(grid, engines, count, head_start, options, stats, winner) solves
+// grid with the count engines at once on a pool of threads kept by the calling thread,
+// and keeps the answer of the first to finish, once the first engine has had head_start
+// nodes to itself. An ENGINE_BITMASK first engine runs as a step_solver, so that it
+// carries on into the race from where its head start stopped
+
+// effects: may mutate grid, stats and winner
+
+// requires: grid, engines and stats must not be NULL, count >= 1, head_start >= 0
+
+// time: O()
+sudoku::solve_result sudoku_solver_race(int grid[DIM + 1][DIM + 1], const enum solver_engine *engines,
+                                        int count, long head_start,
+                                        const sudoku::solve_options &options,
+                                        sudoku::search_stats *stats,
+                                        enum solver_engine *winner){
+  assert(grid);
+  assert(engines);
+  assert(stats);
+  assert(count >= 1);
+  assert(head_start >= 0);
+  static thread_local sudoku::step_solver<BOX_DIM> searches;
+  // a name for the calling thread's search that the pool's threads can use too
+  sudoku::step_solver<BOX_DIM> &leader = searches;
+  const bool resumable = engines[0] == ENGINE_BITMASK;
+  if(resumable){
+    int cells[DIM * DIM];
+    for(int cell = 0; cell < DIM * DIM; ++cell){
+      cells[cell] = grid[cell / DIM][cell % DIM];
+    }
+    leader.load(cells);
+  }
+  if(head_start){
+    sudoku::solve_options alone = options;
+    alone.max_nodes = options.max_nodes && options.max_nodes <= head_start ? options.max_nodes : head_start;
+    sudoku::solve_result result;
+    if(resumable){
+      result = step_within(leader, alone);
+      step_result(leader, result, grid, stats);
+    } else{
+      result = sudoku_solver(grid, engines[0], alone, stats);
+    }
+    if(result != sudoku::SOLVE_EXHAUSTED){
+      if(winner){
+        *winner = engines[0];
+      }
+      return result;
+    }
+    // out of time, cancelled or out of the caller's nodes
+    if(stats->nodes < alone.max_nodes || alone.max_nodes == options.max_nodes){
+      return sudoku::SOLVE_EXHAUSTED;
+    }
+  }
+  // what each engine searches and how it ended
+  struct racer{
+    int grid[DIM + 1][DIM + 1];
+    sudoku::search_stats stats;
+    sudoku::solve_result result;
+  };
+  std::vector<racer> racers(count);
+  for(int k = 0; k < count; ++k){
+    for(int row = 0; row < DIM + 1; ++row){
+      for(int col = 0; col < DIM + 1; ++col){
+        racers[k].grid[row][col] = grid[row][col];
+      }
+    }
+  }
+  // the racers give up on the caller's cancel or on stop, set by the first to finish
+  std::atomic<bool> stop(false);
+  sudoku::solve_options racing = options;
+  racing.stop = &stop;
+  std::mutex lock;
+  int first = -1;
+
+  static thread_local std::unique_ptr<work_stealing_pool> pool;
+  if(!pool || pool->size() < count){
+    pool.reset();
+    pool.reset(new work_stealing_pool(count));
+  }
+  pool->run(count, [&](int k, int){
+    racer &mine = racers[k];
+    if(k == 0 && resumable){
+      mine.result = step_within(leader, racing);
+      step_result(leader, mine.result, mine.grid, &mine.stats);
+    } else{
+      mine.result = sudoku_solver(mine.grid, engines[k], racing, &mine.stats);
+    }
+    std::lock_guard<std::mutex> hold(lock);
+    if(first < 0 && mine.result != sudoku::SOLVE_EXHAUSTED){
+      first = k;
+      stop.store(true, std::memory_order_relaxed);
+    }
+  });
+
+  if(first < 0){
+    *stats = racers[0].stats;
+    return sudoku::SOLVE_EXHAUSTED;
+  }
+  const racer &best = racers[first];
+  if(best.result == sudoku::SOLVE_SOLVED){
+    for(int row = 0; row < DIM; ++row){
+      for(int col = 0; col < DIM; ++col){
+        grid[row][col] = best.grid[row][col];
+      }
+    }
+  }
+  *stats = best.stats;
+  if(winner){
+    *winner = engines[first];
+  }
+  return best.result;
+}
+
+
+
+// sudoku_solver_switching(grid, engines, count, first_nodes, options, stats, winner) runs
+// the engines in turn on node budgets that double every round (see the header)
+
+// effects: may mutate grid, stats and winner
+
+// requires: grid, engines and stats must not be NULL, count >= 1, first_nodes >= 1
+
+// time: O()
+sudoku::solve_result sudoku_solver_switching(int grid[DIM + 1][DIM + 1], const enum solver_engine *engines,
+                                             int count, long first_nodes,
+                                             const sudoku::solve_options &options,
+                                             sudoku::search_stats *stats,
+                                             enum solver_engine *winner){
+  assert(grid);
+  assert(engines);
+  assert(stats);
+  assert(count >= 1);
+  assert(first_nodes >= 1);
+  sudoku::solve_options round = options;
+  for(long nodes = first_nodes; ; nodes = nodes > LONG_MAX / 2 ? LONG_MAX : nodes * 2){
+    const bool capped = options.max_nodes && options.max_nodes <= nodes;
+    round.max_nodes = capped ? options.max_nodes : nodes;
+    for(int k = 0; k < count; ++k){
+      const sudoku::solve_result result = sudoku_solver(grid, engines[k], round, stats);
+      if(result != sudoku::SOLVE_EXHAUSTED){
+        if(winner){
+          *winner = engines[k];
+        }
+        return result;
+      }
+      // stopped short of its nodes: the deadline has passed or the solve was cancelled
+      if(stats->nodes < round.max_nodes){
+        return sudoku::SOLVE_EXHAUSTED;
+      }
+    }
+    if(capped){
+      return sudoku::SOLVE_EXHAUSTED;
+    }
+  }
+}
+
+
+
+// count_solutions(grid, limit) returns the number of solutions of the given grid, counting
+// no further than limit
+
+// requires: grid must not be NULL
+//           limit >= 1
+
+// time: O()
+int count_solutions(int grid[DIM + 1][DIM + 1], int limit){
+  assert(grid);
+  assert(limit >= 1);
+  int cells[DIM * DIM];
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    cells[cell] = grid[cell / DIM][cell % DIM];
+  }
+  static thread_local sudoku::solver<BOX_DIM> board;
+  if(!board.load(cells)){
+    return 0;
+  }
+  return board.count_solutions(limit);
+}
+
+
+
+// count_solutions(grid, limit, options, stats, found) is count_solutions(grid, limit)
+// within the budget of options (see solver::count_solutions(limit, options, stats, found))
+
+// effects: mutates stats and found
+
+// requires: grid, stats and found must not be NULL
+//           limit >= 1
+
+// time: O()
+sudoku::solve_result count_solutions(int grid[DIM + 1][DIM + 1], int limit,
+                                     const sudoku::solve_options &options,
+                                     sudoku::search_stats *stats, int *found){
+  assert(grid);
+  assert(stats);
+  assert(found);
+  assert(limit >= 1);
+  int cells[DIM * DIM];
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    cells[cell] = grid[cell / DIM][cell % DIM];
+  }
+  static thread_local sudoku::solver<BOX_DIM> board;
+  board.load(cells);
+  return board.count_solutions(limit, options, stats, *found);
 }
@@ -1,6 +1,13 @@
 #ifndef BACKTRACKING_SOLVER_H
 #define BACKTRACKING_SOLVER_H
 
+#include "search_stats.h"
+#include "solve_options.h"
+
+namespace sudoku{
+class solution_cache;
+}
+
 struct coordinate;
 // coordinates_equal(coord1, coord2) returns true if the two coordinates refer to
 // the same position and false otherwise
@@ -93,6 +100,21 @@ bool sudoku_solver_wrapper(int grid[][10], int curr_row, int curr_column);
 
 
 
+// sudoku_solver_wrapper(grid, curr_row, curr_column, stats) is
+// sudoku_solver_wrapper(grid, curr_row, curr_column) that also clears stats and fills it
+// in: get_empty_posn() counts as selection and is_valid() as checking
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+//           curr_row and curr_column must be valid indexes
+
+// time: O()
+bool sudoku_solver_wrapper(int grid[][10], int curr_row, int curr_column,
+                           sudoku::search_stats *stats);
+
+
+
 // sudoku_solver(grid) returns true and solves the given grid if it can be solved and returns
 // false otherwise
 
@@ -100,8 +122,173 @@ bool sudoku_solver_wrapper(int grid[][10], int curr_row, int curr_column);
 
 // requires: grid must not be NULL, and grid must be incomplete
 
+// note: runs on sudoku::solver<3> (see solver.h) rather than is_valid()
+
 // time: O()
 bool sudoku_solver(int grid[][10]);
 
 
+
+// sudoku_solver(grid, stats) is sudoku_solver(grid) that also clears stats and fills it
+// in (see solver::solve(stats))
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+
+// time: O()
+bool sudoku_solver(int grid[][10], sudoku::search_stats *stats);
+
+
+
+// sudoku_solver(grid, options, stats) is sudoku_solver(grid, stats) within the budget
+// of options (see solve_options.h): it returns SOLVE_SOLVED with the grid solved,
+// SOLVE_UNSOLVABLE, or SOLVE_EXHAUSTED with the grid unchanged if the budget ran out
+// first, with stats counting the search up to then
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+
+// time: O()
+sudoku::solve_result sudoku_solver(int grid[][10], const sudoku::solve_options &options,
+                                   sudoku::search_stats *stats);
+
+
+
+// sudoku_solver(grid, cache) is sudoku_solver(grid) that looks the grid up in cache first
+// and stores its solution there, so a grid equivalent to one solved before (up to
+// relabelling, row, column, band and stack swaps and transposition; see canonical.h) is
+// answered without searching
+
+// effects: may mutate grid and cache
+
+// requires: grid and cache must not be NULL
+
+// time: O()
+bool sudoku_solver(int grid[][10], sudoku::solution_cache *cache);
+
+
+
+// the engines sudoku_solver(grid, engine) can run on
+enum solver_engine { ENGINE_BITMASK, ENGINE_DLX, ENGINE_ROW_MAJOR, ENGINE_RANDOM_ORDER };
+
+// sudoku_solver(grid, engine) is sudoku_solver(grid) run on the chosen engine:
+// ENGINE_BITMASK is the sudoku::solver search, ENGINE_DLX the exact cover search
+// in sudoku::dlx, ENGINE_ROW_MAJOR the get_empty_posn() and is_valid() search of
+// sudoku_solver_wrapper() and ENGINE_RANDOM_ORDER matrix::solve_dfs(), which tries
+// the numbers of each cell in a random order
+
+// effects: may mutate grid
+
+// requires: grid must not be NULL
+
+// time: O()
+bool sudoku_solver(int grid[][10], enum solver_engine engine);
+
+
+
+// sudoku_solver(grid, engine, options, stats) is sudoku_solver(grid, engine) within the
+// budget of options, like sudoku_solver(grid, options, stats). Each engine counts a node
+// for every cell (or, for ENGINE_DLX, every constraint) it branches on
+
+// effects: may mutate grid and stats
+
+// requires: grid and stats must not be NULL
+
+// time: O()
+sudoku::solve_result sudoku_solver(int grid[][10], enum solver_engine engine,
+                                   const sudoku::solve_options &options,
+                                   sudoku::search_stats *stats);
+
+
+
+// the engines sudoku_solver_race() and sudoku_solver_switching() use by default, fastest
+// on typical boards first
+const enum solver_engine PORTFOLIO[] = {ENGINE_BITMASK, ENGINE_DLX, ENGINE_RANDOM_ORDER,
+                                        ENGINE_ROW_MAJOR};
+const int PORTFOLIO_SIZE = sizeof(PORTFOLIO) / sizeof(PORTFOLIO[0]);
+
+// nodes in which the first engine of PORTFOLIO finishes nearly every 9x9 board: a
+// head_start for sudoku_solver_race() and a first_nodes for sudoku_solver_switching()
+const long PORTFOLIO_NODES = 1000;
+
+
+
+// sudoku_solver_race(grid, engines, count, head_start, options, stats, winner) solves grid
+// with the count engines at once, one thread each, within the budget of options (every
+// engine gets the whole budget). The first engine to solve the grid or show it
+// unsolvable wins and the others are cancelled; stats is filled in with its search and
+// winner, if not NULL, set to it. The threads are a pool kept by each calling thread,
+// so they and the engines on them are only set up by its first race. Handing a board to
+// the pool still costs more than solving an easy board, so the first engine is given
+// head_start nodes on the calling thread first (0 to race from the start), and only
+// boards it cannot finish in them are raced. An ENGINE_BITMASK first engine carries on
+// into the race from where it stopped; any other first engine starts over. The race only
+// pays off with a core free for every engine; on fewer cores the engines share them, and
+// the winner is slowed down by the others
+
+// effects: may mutate grid, stats and winner
+
+// requires: grid, engines and stats must not be NULL, count >= 1, head_start >= 0
+
+// time: O()
+sudoku::solve_result sudoku_solver_race(int grid[][10], const enum solver_engine *engines,
+                                        int count, long head_start,
+                                        const sudoku::solve_options &options,
+                                        sudoku::search_stats *stats,
+                                        enum solver_engine *winner);
+
+
+
+// sudoku_solver_switching(grid, engines, count, first_nodes, options, stats, winner) is
+// a sudoku_solver_race() on one thread: it runs the engines in turn, each for first_nodes
+// nodes, then again for twice as many, and so on, so a board that sends the first
+// engine into a long search is soon handed to another, and no board takes much more
+// than count times as many nodes as the engine best suited to it. Each run is also
+// kept within the budget of options
+
+// effects: may mutate grid, stats and winner
+
+// requires: grid, engines and stats must not be NULL, count >= 1, first_nodes >= 1
+
+// time: O()
+sudoku::solve_result sudoku_solver_switching(int grid[][10], const enum solver_engine *engines,
+                                             int count, long first_nodes,
+                                             const sudoku::solve_options &options,
+                                             sudoku::search_stats *stats,
+                                             enum solver_engine *winner);
+
+
+
+// count_solutions(grid, limit) returns the number of solutions of the given grid, counting
+// no further than limit, so count_solutions(grid, 2) == 1 checks that the solution is
+// unique without enumerating the others
+
+// requires: grid must not be NULL
+//           limit >= 1
+
+// note: runs on sudoku::solver<3> like sudoku_solver(grid); grid is not changed
+
+// time: O()
+int count_solutions(int grid[][10], int limit);
+
+
+
+// count_solutions(grid, limit, options, stats, found) is count_solutions(grid, limit)
+// within the budget of options: it sets found to the solutions counted and returns
+// SOLVE_SOLVED if there are any, SOLVE_UNSOLVABLE if there are none, or SOLVE_EXHAUSTED
+// if the budget ran out first, found then counting the solutions seen so far
+
+// effects: mutates stats and found
+
+// requires: grid, stats and found must not be NULL
+//           limit >= 1
+
+// time: O()
+sudoku::solve_result count_solutions(int grid[][10], int limit,
+                                     const sudoku::solve_options &options,
+                                     sudoku::search_stats *stats, int *found);
+
+
 #endif // BACKTRACKING_SOLVER_H
@@ -0,0 +1,433 @@
+#ifndef CANONICAL_H
+#define CANONICAL_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include "packed_board.h"
+#include "solver.h"
+
+// Canonical forms of 9x9 boards. Relabelling the numbers, reordering the bands, the
+// stacks, the rows within a band and the columns within a stack, and transposing all
+// turn a board into an equivalent one, with the solution transformed the same way. The
+// canonical form of a board is the smallest of all the boards it can be turned into,
+// reading the cells row by row, with the numbers relabelled in the order they are first
+// met and empty cells sorting after every number. Equivalent boards, and only they,
+// share a canonical form, so a solution found for one serves all of them.
+//
+// Of the 2 * 6^8 reorderings only the ones that keep the rows read so far smallest are
+// followed: the search picks the canonical rows one by one, keeping every (reordering,
+// labelling) that ties for the smallest row.
+
+namespace sudoku{
+
+// canonical_form is a board in canonical form together with the transformation that
+// turned the original board into it
+class canonical_form{
+  public:
+  static constexpr int SIDE = 9;
+  static constexpr int CELLS = 81;
+
+  // the canonical board, row-major, 0 for an empty cell
+  std::uint8_t cells[CELLS];
+  // canonical cell (k, j) is cell (rows[k], cols[j]) of the original board, transposed
+  // first if transposed is true, with number n relabelled labels[n]
+  bool transposed;
+  std::uint8_t rows[SIDE];
+  std::uint8_t cols[SIDE];
+  std::uint8_t labels[SIDE + 1];
+
+
+
+  // key() returns the canonical board packed, for hashing and comparing forms
+  packed_board<3> key() const{
+    packed_board<3> packed;
+    for(int k = 0; k < CELLS / 2; ++k){
+      packed.bytes[k] = static_cast<std::uint8_t>(cells[2 * k] | cells[2 * k + 1] << 4);
+    }
+    packed.bytes[CELLS / 2] = cells[CELLS - 1];
+    return packed;
+  }
+
+
+
+  // to_canonical(board, out) transforms board (such as a solution of the original board)
+  // the way the original board was transformed, and from_canonical(board, out) undoes
+  // that, so from_canonical() of the canonical solution solves the original board
+
+  // requires: board and out must hold CELLS values each and must not overlap
+  void to_canonical(const int *board, int *out) const{
+    for(int k = 0; k < SIDE; ++k){
+      for(int j = 0; j < SIDE; ++j){
+        out[k * SIDE + j] = labels[board[original(k, j)]];
+      }
+    }
+  }
+
+  void from_canonical(const int *board, int *out) const{
+    int numbers[SIDE + 1];
+    for(int n = 0; n <= SIDE; ++n){
+      numbers[labels[n]] = n;
+    }
+    for(int k = 0; k < SIDE; ++k){
+      for(int j = 0; j < SIDE; ++j){
+        out[original(k, j)] = numbers[board[k * SIDE + j]];
+      }
+    }
+  }
+
+
+
+  private:
+  // original(k, j) returns the original cell that canonical cell (k, j) comes from
+  int original(int k, int j) const{
+    return transposed ? cols[j] * SIDE + rows[k] : rows[k] * SIDE + cols[j];
+  }
+};
+
+
+
+// canonicalizer finds canonical forms; it keeps its work space between calls, so one
+// object should be reused for many boards (by one thread at a time)
+class canonicalizer{
+  public:
+  static constexpr int SIDE = canonical_form::SIDE;
+  static constexpr int CELLS = canonical_form::CELLS;
+  // reorderings of the columns: 3! orders of the stacks times 3! orders within each
+  static constexpr int COLUMN_ORDERS = 6 * 6 * 6 * 6;
+  // the most (reordering, labelling) pairs followed at once
+  static constexpr size_t MAX_STATES = 1 << 17;
+
+  // column order stacks + 6 * w0 + 36 * w1 + 216 * w2 takes the stacks in order
+  // permutation(stacks, .) and the columns of the stack at position s in order
+  // permutation(ws, .)
+  canonicalizer(){
+    for(int order = 0; order < COLUMN_ORDERS; ++order){
+      for(int s = 0, within = order / 6; s < 3; ++s, within /= 6){
+        for(int c = 0; c < 3; ++c){
+          column_orders[order][s * 3 + c] =
+              static_cast<std::uint8_t>(permutation(order % 6, s) * 3 + permutation(within % 6, c));
+        }
+      }
+    }
+  }
+
+
+
+  // canonicalize(board, form) sets form to the canonical form of the row-major board and
+  // returns true, or returns false if a number repeats in a row or column, or if the
+  // board is so symmetric (a nearly empty board, say) that more than MAX_STATES
+  // reorderings tie along the way; such a board has no form here, and should be treated
+  // as distinct from every other
+
+  // requires: board must hold CELLS numbers from 0 to SIDE
+
+  // time: O(s) where s is the number of reorderings that tie for the smallest rows
+  bool canonicalize(const int *board, canonical_form &form){
+    int boards[2][CELLS];
+    for(int cell = 0; cell < CELLS; ++cell){
+      boards[0][cell] = board[cell];
+      boards[1][cell] = board[cell % SIDE * SIDE + cell / SIDE];
+    }
+    // the first row shows only where the clues are, since its numbers are labelled 1, 2,
+    // ... in turn. The smallest first rows come from the rows whose clue counts per stack,
+    // largest first, are greatest, with the stacks in that order and the clues of each
+    // stack first; only the column orders that do that are followed
+    int shapes[2][SIDE];
+    int best_shape = 0;
+    for(int t = 0; t < 2; ++t){
+      for(int row = 0; row < SIDE; ++row){
+        int counts[3] = {0, 0, 0};
+        int seen = 0;
+        for(int col = 0; col < SIDE; ++col){
+          const int n = boards[t][row * SIDE + col];
+          if(n && (seen >> n & 1)){
+            return false;
+          }
+          seen |= 1 << n;
+          counts[col / 3] += n != 0;
+        }
+        std::sort(counts, counts + 3);
+        shapes[t][row] = counts[2] * 16 + counts[1] * 4 + counts[0];
+        best_shape = shapes[t][row] > best_shape ? shapes[t][row] : best_shape;
+      }
+    }
+    // the clues of the best first row, as bits from the left
+    int best_clues = 0;
+    for(int s = 0; s < 3; ++s){
+      const int count = best_shape >> (2 * (2 - s)) & 3;
+      best_clues |= (7 << (3 - count) & 7) << (3 * (2 - s));
+    }
+    states.clear();
+    for(int t = 0; t < 2; ++t){
+      for(int row = 0; row < SIDE; ++row){
+        if(shapes[t][row] != best_shape){
+          continue;
+        }
+        const int *cells = boards[t] + row * SIDE;
+        // bit c of stack_clues[s] is set if column c of stack s holds a clue
+        int stack_clues[3] = {0, 0, 0};
+        for(int col = 0; col < SIDE; ++col){
+          stack_clues[col / 3] |= (cells[col] != 0) << (col % 3);
+        }
+        for(int stacks = 0; stacks < 6; ++stacks){
+          // the orders within the stack put at position s that move its clues where
+          // best_clues has them
+          int fits[3][6], fit_count[3];
+          for(int s = 0; s < 3; ++s){
+            const int clues = stack_clues[permutation(stacks, s)];
+            const int wanted = best_clues >> (3 * (2 - s)) & 7;
+            fit_count[s] = 0;
+            for(int within = 0; within < 6; ++within){
+              int moved = 0;
+              for(int c = 0; c < 3; ++c){
+                moved = moved << 1 | (clues >> permutation(within, c) & 1);
+              }
+              if(moved == wanted){
+                fits[s][fit_count[s]++] = within;
+              }
+            }
+          }
+          for(int a = 0; a < fit_count[0]; ++a){
+            for(int b = 0; b < fit_count[1]; ++b){
+              for(int c = 0; c < fit_count[2]; ++c){
+                state start;
+                start.transposed = static_cast<std::uint8_t>(t);
+                start.order = static_cast<std::uint16_t>(stacks + 6 * fits[0][a] + 36 * fits[1][b] +
+                                                         216 * fits[2][c]);
+                start.used = static_cast<std::uint16_t>(1 << row);
+                start.rows[0] = static_cast<std::uint8_t>(row);
+                memset(start.labels, 0, sizeof(start.labels));
+                start.next_label = 1;
+                const std::uint8_t *cols = column_orders[start.order];
+                for(int j = 0; j < SIDE; ++j){
+                  if(cells[cols[j]]){
+                    start.labels[cells[cols[j]]] = start.next_label++;
+                  }
+                }
+                states.push_back(start);
+              }
+            }
+          }
+        }
+      }
+    }
+    for(int j = 0, label = 0; j < SIDE; ++j){
+      form.cells[j] = static_cast<std::uint8_t>(best_clues >> (SIDE - 1 - j) & 1 ? ++label : 0);
+    }
+
+    for(int k = 1; k < SIDE; ++k){
+      std::uint8_t best[SIDE];
+      bool have_best = false;
+      next.clear();
+      for(size_t s = 0; s < states.size(); ++s){
+        const state &from = states[s];
+        const int *cells = boards[from.transposed];
+        const std::uint8_t *cols = column_orders[from.order];
+        // the first row of a band may come from any band not used yet, the others from
+        // the band of that first row
+        int first = 0, last = SIDE;
+        if(k % 3){
+          first = from.rows[k - k % 3] / 3 * 3;
+          last = first + 3;
+        }
+        for(int row = first; row < last; ++row){
+          if((from.used >> row & 1) || (k % 3 == 0 && (from.used >> (row / 3 * 3) & 7))){
+            continue;
+          }
+          std::uint8_t labels[SIDE + 1];
+          memcpy(labels, from.labels, sizeof(labels));
+          std::uint8_t next_label = from.next_label;
+          std::uint8_t values[SIDE];
+          // -1 while the row ties with best so far, then whether it is smaller
+          int compare = have_best ? 0 : -1;
+          for(int j = 0; j < SIDE; ++j){
+            const int n = cells[row * SIDE + cols[j]];
+            if(n && !labels[n]){
+              labels[n] = next_label++;
+            }
+            values[j] = static_cast<std::uint8_t>(n ? labels[n] : EMPTY);
+            if(compare == 0 && values[j] != best[j]){
+              compare = values[j] < best[j] ? -1 : 1;
+              if(compare > 0){
+                break;
+              }
+            }
+          }
+          if(compare > 0){
+            continue;
+          }
+          if(compare < 0 && have_best){
+            next.clear();
+          }
+          if(!have_best || compare < 0){
+            memcpy(best, values, sizeof(best));
+            have_best = true;
+          }
+          if(next.size() == MAX_STATES){
+            return false;
+          }
+          state to = from;
+          to.rows[k] = static_cast<std::uint8_t>(row);
+          to.used = static_cast<std::uint16_t>(from.used | 1 << row);
+          memcpy(to.labels, labels, sizeof(labels));
+          to.next_label = next_label;
+          next.push_back(to);
+        }
+      }
+      states.swap(next);
+      for(int j = 0; j < SIDE; ++j){
+        form.cells[k * SIDE + j] = static_cast<std::uint8_t>(best[j] == EMPTY ? 0 : best[j]);
+      }
+    }
+
+    // every state left gives the same board; numbers the board lacks take the labels
+    // left over, so the relabelling is one to one
+    const state &found = states[0];
+    form.transposed = found.transposed != 0;
+    memcpy(form.rows, found.rows, sizeof(form.rows));
+    memcpy(form.cols, column_orders[found.order], sizeof(form.cols));
+    memcpy(form.labels, found.labels, sizeof(form.labels));
+    std::uint8_t next_label = found.next_label;
+    for(int n = 1; n <= SIDE; ++n){
+      if(!form.labels[n]){
+        form.labels[n] = next_label++;
+      }
+    }
+    return true;
+  }
+
+
+
+  private:
+  // permutation(p, k) returns entry k of order p of 0, 1 and 2
+
+  // requires: 0 <= p < 6, 0 <= k < 3
+  static int permutation(int p, int k){
+    static const int orders[6][3] = {{0, 1, 2}, {0, 2, 1}, {1, 0, 2}, {1, 2, 0}, {2, 0, 1}, {2, 1, 0}};
+    return orders[p][k];
+  }
+
+  // canonical rows sort an empty cell after every number
+  static constexpr int EMPTY = SIDE + 1;
+
+  // one reordering and labelling being followed: the canonical rows picked so far, which
+  // original rows they use, and the labels given so far
+  struct state{
+    std::uint8_t transposed;
+    std::uint16_t order;
+    std::uint16_t used;
+    std::uint8_t rows[SIDE];
+    std::uint8_t labels[SIDE + 1];
+    std::uint8_t next_label;
+  };
+
+  std::uint8_t column_orders[COLUMN_ORDERS][SIDE];
+  std::vector<state> states, next;
+};
+
+
+
+// solution_cache remembers the solutions of up to capacity boards by canonical form,
+// dropping the least recently used, so a board equivalent to one solved before is
+// answered by transforming the cached solution instead of searching again. It is not
+// thread safe: give each thread its own
+class solution_cache{
+  public:
+  static constexpr int CELLS = canonical_form::CELLS;
+
+  // lookups answered from the cache, lookups that had to search, and boards too
+  // symmetric to have a canonical form (which are searched every time)
+  long hits, misses, uncached;
+
+  // requires: capacity >= 1
+  explicit solution_cache(size_t capacity) : hits(0), misses(0), uncached(0), capacity(capacity){}
+
+
+
+  // solve(cells) solves the row-major 9x9 board in cells in place and returns true, or
+  // returns false (leaving cells as they were) if it has no solution
+
+  // effects: may mutate cells
+
+  // requires: cells must hold CELLS numbers from 0 to 9
+
+  // time: O(s) to canonicalize (see canonicalizer::canonicalize) plus a search on a miss
+  bool solve(int *cells){
+    canonical_form form;
+    if(!canon.canonicalize(cells, form)){
+      ++uncached;
+      return search(cells);
+    }
+    const packed_board<3> key = form.key();
+    const index_map::iterator found = index.find(key);
+    if(found != index.end()){
+      ++hits;
+      entries.splice(entries.begin(), entries, found->second);
+      const entry &cached = *found->second;
+      if(!cached.solvable){
+        return false;
+      }
+      int solution[CELLS];
+      cached.solution.unpack(solution);
+      form.from_canonical(solution, cells);
+      return true;
+    }
+    ++misses;
+    entry fresh;
+    fresh.key = key;
+    fresh.solvable = search(cells);
+    if(fresh.solvable){
+      int solution[CELLS];
+      form.to_canonical(cells, solution);
+      fresh.solution.pack(solution);
+    }
+    if(index.size() == capacity){
+      index.erase(entries.back().key);
+      entries.pop_back();
+    }
+    entries.push_front(fresh);
+    index[key] = entries.begin();
+    return fresh.solvable;
+  }
+
+
+
+  // size() returns the number of boards cached
+  size_t size() const{
+    return index.size();
+  }
+
+
+
+  private:
+  // keys and solutions are packed, 41 bytes each, so large caches stay small
+  struct entry{
+    packed_board<3> key;
+    bool solvable;
+    packed_board<3> solution;
+  };
+  typedef std::unordered_map<packed_board<3>, std::list<entry>::iterator, packed_board<3>::hasher> index_map;
+
+  size_t capacity;
+  canonicalizer canon;
+  solver<3> board;
+  // most recently used first
+  std::list<entry> entries;
+  index_map index;
+
+  bool search(int *cells){
+    if(!board.load(cells) || !board.solve()){
+      return false;
+    }
+    board.store(cells);
+    return true;
+  }
+};
+
+}
+
+#endif // CANONICAL_H
@@ -0,0 +1,256 @@
+#include "dlx.h"
+#include <cassert>
+
+// dlx(box_dim) links the full exact cover matrix for a board with blocks of
+// box_dim x box_dim cells. Node 0 is the root, nodes 1..columns the column
+// headers and every row gets four consecutive nodes after them
+
+// requires: box_dim >= 2 (9x9, 16x16 and 25x25 boards use 3, 4 and 5)
+sudoku::dlx::dlx(int box_dim)
+{
+    assert(box_dim >= 2);
+    this->box_dim = box_dim;
+    this->n = box_dim * box_dim;
+    this->columns = 4 * n * n;
+    this->head = 0;
+    int total = 1 + this->columns + 4 * n * n * n;
+    left.resize(total);
+    right.resize(total);
+    up.resize(total);
+    down.resize(total);
+    column.resize(total);
+    choice.resize(total);
+    count.assign(this->columns + 1, 0);
+    covered.assign(this->columns + 1, false);
+    solution.resize(n * n);
+    this->depth = 0;
+
+    for (int c = 0; c <= this->columns; ++c)
+    {
+        left[c] = c ? c - 1 : this->columns;
+        right[c] = c < this->columns ? c + 1 : 0;
+        up[c] = down[c] = column[c] = c;
+        choice[c] = -1;
+    }
+    for (int cell = 0; cell < n * n; ++cell)
+    {
+        int i = cell / n, j = cell % n;
+        int b = (i / box_dim) * box_dim + j / box_dim;
+        for (int d = 0; d < n; ++d)
+        {
+            int cols[4] = {1 + cell,
+                           1 + n * n + i * n + d,
+                           1 + 2 * n * n + j * n + d,
+                           1 + 3 * n * n + b * n + d};
+            link_row(cell * n + d, cols);
+        }
+    }
+}
+
+// link_row(r, cols) appends the four nodes of row r to the bottom of the given columns
+
+// time: O(1)
+void sudoku::dlx::link_row(int r, const int *cols)
+{
+    int base = 1 + this->columns + 4 * r;
+    for (int k = 0; k < 4; ++k)
+    {
+        int node = base + k;
+        int c = cols[k];
+        column[node] = c;
+        choice[node] = r;
+        up[node] = up[c];
+        down[node] = c;
+        down[up[c]] = node;
+        up[c] = node;
+        ++count[c];
+        left[node] = base + (k + 3) % 4;
+        right[node] = base + (k + 1) % 4;
+    }
+}
+
+void sudoku::dlx::cover(int c)
+{
+    right[left[c]] = right[c];
+    left[right[c]] = left[c];
+    for (int i = down[c]; i != c; i = down[i])
+    {
+        for (int j = right[i]; j != i; j = right[j])
+        {
+            down[up[j]] = down[j];
+            up[down[j]] = up[j];
+            --count[column[j]];
+        }
+    }
+    covered[c] = true;
+}
+
+void sudoku::dlx::uncover(int c)
+{
+    for (int i = up[c]; i != c; i = up[i])
+    {
+        for (int j = left[i]; j != i; j = left[j])
+        {
+            ++count[column[j]];
+            down[up[j]] = j;
+            up[down[j]] = j;
+        }
+    }
+    right[left[c]] = c;
+    left[right[c]] = c;
+    covered[c] = false;
+}
+
+// select(r) commits to row r for a given clue, returning false without changing
+// anything if one of its constraints is already satisfied by another clue
+
+// time: O(n) where n is the number of nodes removed
+bool sudoku::dlx::select(int r)
+{
+    int node = 1 + this->columns + 4 * r;
+    for (int k = 0; k < 4; ++k)
+    {
+        if (covered[column[node + k]])
+            return false;
+    }
+    cover(column[node]);
+    for (int j = right[node]; j != node; j = right[j])
+        cover(column[j]);
+    solution[this->depth++] = node;
+    return true;
+}
+
+// deselect(node) uncovers what select() or search() covered for the row of node
+
+void sudoku::dlx::deselect(int node)
+{
+    for (int j = left[node]; j != node; j = left[j])
+        uncover(column[j]);
+    uncover(column[node]);
+}
+
+// search(depth, counter) runs Algorithm X, always branching on the column with
+// the fewest rows left, with depth rows already chosen by the search, reporting
+// to counter. On success the chosen nodes are left on the solution stack with
+// their columns covered; on failure, or once counter halts it, everything it
+// covered is restored
+template <class COUNTER>
+bool sudoku::dlx::search(int depth, COUNTER &counter)
+{
+    if (right[this->head] == this->head)
+        return true;
+    counter.node(depth);
+    if (counter.halt())
+        return false;
+    std::uint64_t since = counter.start();
+    int c = right[this->head];
+    for (int k = right[c]; k != this->head; k = right[k])
+    {
+        if (count[k] < count[c])
+            c = k;
+    }
+    counter.selected(since);
+    if (!count[c])
+        return false;
+    cover(c);
+    for (int r = down[c]; r != c; r = down[r])
+    {
+        solution[this->depth++] = r;
+        for (int j = right[r]; j != r; j = right[j])
+            cover(column[j]);
+        counter.guessed();
+        if (search(depth + 1, counter))
+            return true;
+        for (int j = left[r]; j != r; j = left[j])
+            uncover(column[j]);
+        --this->depth;
+        counter.undone(1);
+    }
+    uncover(c);
+    return false;
+}
+
+// solve_with(cells, counter) is solve(cells) with the search reporting to counter
+
+// effects: may mutate cells
+template <class COUNTER>
+bool sudoku::dlx::solve_with(int *cells, COUNTER &counter)
+{
+    assert(cells);
+    assert(!this->depth);
+    bool ok = true;
+    for (int cell = 0; ok && cell < n * n; ++cell)
+    {
+        int val = cells[cell];
+        if (val < 0 || val > n)
+            ok = false;
+        else if (val)
+            ok = select(cell * n + val - 1);
+    }
+    ok = ok && search(0, counter);
+    if (ok)
+    {
+        for (int k = 0; k < this->depth; ++k)
+        {
+            int r = choice[solution[k]];
+            cells[r / n] = r % n + 1;
+        }
+    }
+    while (this->depth)
+        deselect(solution[--this->depth]);
+    return ok;
+}
+
+// solve(cells) returns true and fills in the n*n row-major board cells (0 for an
+// empty cell) if it can be solved and returns false otherwise. The links are
+// restored before returning, so the object is ready for the next board
+
+// effects: may mutate cells
+
+// requires: cells must hold size() * size() values
+bool sudoku::dlx::solve(int *cells)
+{
+    no_counter counter(NULL);
+    return solve_with(cells, counter);
+}
+
+// solve(cells, options, stats) is solve(cells) within the budget of options (see
+// solve_options.h), counting a node for every column branched on: it returns
+// SOLVE_SOLVED with cells solved, SOLVE_UNSOLVABLE, or SOLVE_EXHAUSTED with cells
+// unchanged if the budget ran out first, with stats counting the search so far
+
+// effects: may mutate cells and stats
+
+// requires: cells must hold size() * size() values, stats must not be NULL
+sudoku::solve_result sudoku::dlx::solve(int *cells, const solve_options &options, search_stats *stats)
+{
+    stats->clear();
+    budget_counter counter(stats, options);
+    const bool solved = solve_with(cells, counter);
+    stats->nodes = counter.nodes_searched();
+    return solved ? SOLVE_SOLVED : counter.halted() ? SOLVE_EXHAUSTED : SOLVE_UNSOLVABLE;
+}
+
+// solve(mat) is solve(cells) for the 10x10 padded 9x9 boards used by matrix
+// and sudoku_solver()
+
+// requires: the object was built with box_dim 3
+bool sudoku::dlx::solve(int (*mat)[10])
+{
+    assert(this->n == 9);
+    int cells[81];
+    for (int i = 0; i < 9; ++i)
+        for (int j = 0; j < 9; ++j)
+            cells[i * 9 + j] = mat[i][j];
+    if (!solve(cells))
+        return false;
+    for (int i = 0; i < 9; ++i)
+        for (int j = 0; j < 9; ++j)
+            mat[i][j] = cells[i * 9 + j];
+    return true;
+}
+
+int sudoku::dlx::size()
+{
+    return this->n;
+}
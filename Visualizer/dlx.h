@@ -0,0 +1,44 @@
+#ifndef DLX_H
+#define DLX_H
+
+#include <vector>
+#include "solve_options.h"
+
+namespace sudoku{
+	// dlx solves an n x n sudoku (n = box_dim^2) as an exact cover problem with
+	// Knuth's dancing links. The 4n^2 columns are the cell, row-number,
+	// column-number and block-number constraints, and each of the n^3 rows is
+	// one (cell, number) choice. All nodes live in one pool built by the
+	// constructor, so solving never allocates and the same object can be
+	// reused for any number of boards of its size.
+	class dlx{
+		public:
+		dlx(int box_dim);
+		bool solve(int *cells);
+		sudoku::solve_result solve(int *cells, const sudoku::solve_options &options, sudoku::search_stats *stats);
+		bool solve(int (*mat)[10]);
+		int size();
+
+		private:
+		int box_dim;
+		int n;
+		int columns;
+		int head;
+		std::vector<int> left, right, up, down, column, choice;
+		std::vector<int> count;
+		std::vector<bool> covered;
+		std::vector<int> solution;
+		int depth;
+		void link_row(int r, const int *cols);
+		void cover(int c);
+		void uncover(int c);
+		bool select(int r);
+		void deselect(int r);
+		template <class COUNTER>
+		bool search(int depth, COUNTER &counter);
+		template <class COUNTER>
+		bool solve_with(int *cells, COUNTER &counter);
+	};
+}
+
+#endif // DLX_H
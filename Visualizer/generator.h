@@ -0,0 +1,297 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include <cstdint>
+#include "random.h"
+#include "solver.h"
+
+// Puzzle generator built on sudoku::solver. A random complete board is filled in by a
+// randomised search, then clues are taken away one symmetry orbit at a time in random
+// order, keeping only the removals after which the solution is still unique.
+
+namespace sudoku{
+
+// which cells are removed together, so the clues of the puzzle keep that symmetry
+enum symmetry { SYMMETRY_NONE, SYMMETRY_ROTATIONAL, SYMMETRY_MIRROR, SYMMETRY_DIAGONAL };
+
+template <int BOX_DIM>
+class generator{
+  public:
+  typedef solver<BOX_DIM> solver_type;
+  typedef typename solver_type::mask_t mask_t;
+  static constexpr int SIDE = solver_type::SIDE;
+  static constexpr int CELLS = solver_type::CELLS;
+  // nodes a fill may take before it gives up and starts again from an empty board
+  static constexpr long FILL_BUDGET = 64L * CELLS;
+
+  // generator(seed) prepares a generator whose puzzles are fixed by seed
+  explicit generator(std::uint64_t seed) : limits(NULL), spent(0), next_check(0),
+                                           exhausted(false){
+    // the board is reloaded for every removal, which the scan mode does without
+    // rebuilding the candidate buckets
+    board.set_selection(SELECT_MRV_SCAN, TIE_FIRST);
+    reseed(seed);
+  }
+
+
+
+  // reseed(seed) restarts the random sequence, so the same seed gives the same puzzles
+  void reseed(std::uint64_t seed){
+    random.reseed(seed);
+  }
+
+
+
+  // fill(cells) writes a random complete board into cells
+
+  // requires: cells must hold CELLS values
+
+  // time: O(n^2 * p) where n is SIDE and p is PEERS, restarts aside
+  void fill(int *cells){
+    fill_answer();
+    for(int cell = 0; cell < CELLS; ++cell){
+      cells[cell] = answer[cell];
+    }
+  }
+
+
+
+  // generate(cells, target, sym) writes a random puzzle with a unique solution into cells
+  // and returns its number of clues. Orbits of sym are removed while at least target clues
+  // remain; a removal that fails once would fail again later, so one pass over the orbits
+  // leaves either target clues (give or take an orbit) or a puzzle none of whose orbits
+  // can be taken away. target = 0 asks for such a minimal puzzle
+
+  // requires: cells must hold CELLS values
+
+  // time: O(n * s) where n is CELLS and s is the cost of one solve
+  int generate(int *cells, int target, symmetry sym){
+    if(!fill_answer()){
+      return -1;
+    }
+    for(int cell = 0; cell < CELLS; ++cell){
+      puzzle[cell] = answer[cell];
+    }
+    int clues = CELLS;
+    for(int k = 0; k < CELLS; ++k){
+      order[k] = k;
+    }
+    for(int k = CELLS - 1; k > 0; --k){
+      const int other = below(k + 1);
+      const int cell = order[k];
+      order[k] = order[other];
+      order[other] = cell;
+    }
+    for(int k = 0; k < CELLS && clues > target && !exhausted; ++k){
+      const int cell = order[k];
+      if(!puzzle[cell]){
+        continue;
+      }
+      const int partner = mirror(cell, sym);
+      const int size = partner == cell ? 1 : 2;
+      if(clues - size < target){
+        continue;
+      }
+      puzzle[cell] = 0;
+      puzzle[partner] = 0;
+      if(unique(cell, partner)){
+        clues -= size;
+      } else{
+        puzzle[cell] = answer[cell];
+        puzzle[partner] = answer[partner];
+      }
+    }
+    if(exhausted){
+      return -1;
+    }
+    for(int cell = 0; cell < CELLS; ++cell){
+      cells[cell] = puzzle[cell];
+    }
+    return clues;
+  }
+
+
+
+  // generate(cells, target, sym, options, stats) is generate(cells, target, sym) within
+  // the budget of options, which the fill and all the uniqueness searches share. It
+  // returns -1, leaving cells as they were, if the budget runs out first; stats->nodes
+  // counts the nodes searched either way
+
+  // requires: cells must hold CELLS values, stats must not be NULL
+  int generate(int *cells, int target, symmetry sym, const solve_options &options,
+               search_stats *stats){
+    stats->clear();
+    limits = &options;
+    spent = 0;
+    next_check = 0;
+    exhausted = false;
+    const int clues = generate(cells, target, sym);
+    limits = NULL;
+    exhausted = false;
+    stats->nodes = spent;
+    return clues;
+  }
+
+
+
+  // solution(cells) writes the solution of the last board from fill() or generate() into
+  // cells
+
+  // requires: cells must hold CELLS values
+  void solution(int *cells) const{
+    for(int cell = 0; cell < CELLS; ++cell){
+      cells[cell] = answer[cell];
+    }
+  }
+
+
+
+  private:
+  solver_type board;
+  xoshiro256 random;
+  int answer[CELLS];
+  int puzzle[CELLS];
+  int order[CELLS];
+  // the budget of the generate() running, or NULL for none, the nodes it has spent, when
+  // to next look at its deadline and flags, and whether it has run out
+  const solve_options *limits;
+  long spent;
+  long next_check;
+  bool exhausted;
+
+  // below(n) returns a random number in [0, n)
+  int below(int n){
+    return static_cast<int>(random.below(n));
+  }
+
+  // mirror(cell, sym) returns the cell that sym pairs with cell (cell itself if none)
+  static int mirror(int cell, symmetry sym){
+    const int row = cell / SIDE;
+    const int col = cell % SIDE;
+    switch(sym){
+      case SYMMETRY_ROTATIONAL: return (SIDE - 1 - row) * SIDE + SIDE - 1 - col;
+      case SYMMETRY_MIRROR: return row * SIDE + SIDE - 1 - col;
+      case SYMMETRY_DIAGONAL: return col * SIDE + row;
+      default: return cell;
+    }
+  }
+
+  // fill_answer() fills answer with a random complete board, restarting from an empty
+  // board whenever a fill runs over FILL_BUDGET, and returns false if the budget of
+  // generate() runs out first
+  bool fill_answer(){
+    const int empty[CELLS] = {};
+    for(;;){
+      board.load(empty);
+      long budget = FILL_BUDGET;
+      if(fill_from(0, budget)){
+        break;
+      }
+      if(exhausted){
+        return false;
+      }
+    }
+    board.store(answer);
+    return true;
+  }
+
+  // spend() counts a node of fill_from() against the budget of generate(), if there is
+  // one, and returns true once the budget has run out
+  bool spend(){
+    if(!limits || exhausted){
+      return exhausted;
+    }
+    ++spent;
+    if(limits->max_nodes && spent > limits->max_nodes){
+      exhausted = true;
+    } else if(spent >= next_check){
+      next_check = spent + limits->check_interval;
+      exhausted = limits->cancelled() || solve_options::clock::now() >= limits->deadline;
+    }
+    return exhausted;
+  }
+
+  // search_within() is board.search(0) within what is left of the budget of generate(),
+  // if there is one; it returns false if the budget runs out first
+  bool search_within(){
+    if(!limits){
+      return board.search(0);
+    }
+    solve_options left = *limits;
+    if(left.max_nodes){
+      if(spent >= left.max_nodes){
+        exhausted = true;
+        return false;
+      }
+      left.max_nodes -= spent;
+    }
+    search_stats stats;
+    const solve_result result = board.solve(left, &stats);
+    spent += stats.nodes;
+    exhausted = result == SOLVE_EXHAUSTED;
+    return result == SOLVE_SOLVED;
+  }
+
+  // fill_from(start, budget) completes the board like solver::search(start), trying the
+  // candidates of each cell in random order, and gives up once budget nodes are spent
+  bool fill_from(int start, long &budget){
+    if(--budget < 0 || spend()){
+      return false;
+    }
+    const int mark = board.trail_size();
+    if(!board.propagate()){
+      board.undo(mark);
+      return false;
+    }
+    const int cell = board.next_cell(start);
+    if(cell == solver_type::FULL){
+      return true;
+    }
+    for(mask_t cands = board.candidates(cell); cands; ){
+      mask_t pick = cands;
+      for(int skip = below(solver_type::popcount(cands)); skip > 0; --skip){
+        pick &= pick - 1;
+      }
+      pick &= ~pick + 1;
+      cands &= ~pick;
+      const int guess = board.trail_size();
+      board.assign(cell, solver_type::lowest(pick) + 1);
+      if(fill_from(cell, budget)){
+        return true;
+      }
+      board.undo(guess);
+    }
+    board.undo(mark);
+    return false;
+  }
+
+  // unique(first, second) returns true if puzzle, with first and second just emptied, has
+  // no solution other than answer. Any other solution differs from answer at first, or
+  // agrees there and differs at second, so only those boards are searched; each of them
+  // usually dies in propagation, which is much cheaper than counting solutions
+  bool unique(int first, int second){
+    if(!board.load(puzzle)){
+      return false;
+    }
+    const int removed[2] = {first, second};
+    for(int k = 0; k < (first == second ? 1 : 2); ++k){
+      const int cell = removed[k];
+      const mask_t keep = solver_type::bit(answer[cell]);
+      for(mask_t cands = board.candidates(cell) & ~keep; cands; cands &= cands - 1){
+        const int mark = board.trail_size();
+        board.assign(cell, solver_type::lowest(cands) + 1);
+        const bool other = search_within();
+        board.undo(mark);
+        if(other || exhausted){
+          return false;
+        }
+      }
+      board.assign(cell, answer[cell]);
+    }
+    return true;
+  }
+};
+
+}
+
+#endif // GENERATOR_H
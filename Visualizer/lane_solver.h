@@ -0,0 +1,226 @@
+#ifndef LANE_SOLVER_H
+#define LANE_SOLVER_H
+
+#include <cstdint>
+#include <cstring>
+#include "solver.h"
+
+// Solving many 9x9 boards at once. The candidate masks of LANES boards are kept cell by
+// cell in structure-of-arrays form, so that the masks of one cell in all the boards make
+// one vector of 16-bit lanes, and naked and hidden singles are propagated on every board
+// with the same vector instructions. Most easy boards come out solved; the boards that
+// would need a guess are finished one at a time by solver<3>, starting from what the
+// propagation found.
+//
+// The propagation is written once with GCC vector types and compiled for AVX-512 (BW and
+// VL, which add mask registers), for AVX2 and for the compiler's baseline (SSE2 on x86-64,
+// plain scalar code elsewhere). The kernel is chosen once at runtime, as in simd_scan.h.
+
+namespace sudoku{
+namespace simd{
+
+// boards solved together
+const int LANES = 16;
+
+typedef std::uint16_t lane_vector __attribute__((vector_size(2 * LANES)));
+
+
+
+// propagate_lanes_body(masks) propagates naked and hidden singles in the LANES boards
+// whose candidate masks are in masks (cell-major: the masks of cell c are
+// masks[c * LANES .. c * LANES + LANES - 1]) until none of them changes any more, and
+// returns a bitmask of the boards shown to be contradictory. It is inlined into each
+// kernel so that every copy is compiled for that kernel's instruction set
+
+// time: O(n) passes of O(c) vector operations where n is the number of candidates removed
+//       and c the number of cells
+__attribute__((always_inline)) inline std::uint32_t propagate_lanes_body(std::uint16_t *masks){
+  const solver_tables<3> &tables = solver<3>::tables;
+  lane_vector cand[81];
+  memcpy(cand, masks, sizeof(cand));
+  const lane_vector zero = {};
+  const lane_vector all = zero + 0x1ff;
+  lane_vector dead = zero;
+  for(;;){
+    lane_vector changed = zero;
+    // naked singles: every cell down to one candidate takes it out of its peers, and two
+    // such cells with the same number in one unit make the board contradictory
+    lane_vector fixed[27];
+    for(int u = 0; u < 27; ++u){
+      lane_vector once = zero, twice = zero;
+      for(int k = 0; k < 9; ++k){
+        const lane_vector x = cand[tables.units[u][k]];
+        const lane_vector single = x & (lane_vector)((x & (x - 1)) == zero);
+        twice |= once & single;
+        once |= single;
+      }
+      dead |= (lane_vector)(twice != zero);
+      fixed[u] = once;
+    }
+    for(int cell = 0; cell < 81; ++cell){
+      const lane_vector x = cand[cell];
+      const lane_vector several = (lane_vector)((x & (x - 1)) != zero);
+      const lane_vector y = x & ~(several & (fixed[tables.row[cell]] | fixed[9 + tables.col[cell]] |
+                                             fixed[18 + tables.box[cell]]));
+      changed |= x ^ y;
+      dead |= (lane_vector)(y == zero);
+      cand[cell] = y;
+    }
+    // hidden singles: a number with one possible cell in a unit goes there, a number
+    // with none, or two numbers needing the same cell, make the board contradictory
+    for(int u = 0; u < 27; ++u){
+      lane_vector once = zero, twice = zero;
+      for(int k = 0; k < 9; ++k){
+        const lane_vector x = cand[tables.units[u][k]];
+        twice |= once & x;
+        once |= x;
+      }
+      dead |= (lane_vector)(once != all);
+      const lane_vector hidden = once & ~twice;
+      for(int k = 0; k < 9; ++k){
+        const lane_vector x = cand[tables.units[u][k]];
+        const lane_vector h = x & hidden;
+        const lane_vector take = (lane_vector)(h != zero);
+        dead |= (lane_vector)((h & (h - 1)) != zero);
+        const lane_vector y = (h & take) | (x & ~take);
+        changed |= x ^ y;
+        cand[tables.units[u][k]] = y;
+      }
+    }
+    // the contradictory boards may go on changing; stop once the others are settled
+    changed &= ~dead;
+    std::uint16_t any = 0;
+    for(int k = 0; k < LANES; ++k){
+      any |= changed[k];
+    }
+    if(!any){
+      break;
+    }
+  }
+  memcpy(masks, cand, sizeof(cand));
+  std::uint32_t result = 0;
+  for(int k = 0; k < LANES; ++k){
+    result |= dead[k] ? 1u << k : 0;
+  }
+  return result;
+}
+
+
+
+// propagate_lanes_generic(masks) is propagate_lanes_body() for the baseline instruction set
+inline std::uint32_t propagate_lanes_generic(std::uint16_t *masks){
+  return propagate_lanes_body(masks);
+}
+
+#ifdef SIMD_SCAN_X86
+
+// propagate_lanes_avx2(masks) does every lane_vector operation in one AVX2 instruction
+__attribute__((target("avx2")))
+inline std::uint32_t propagate_lanes_avx2(std::uint16_t *masks){
+  return propagate_lanes_body(masks);
+}
+
+// propagate_lanes_avx512(masks) also keeps the lane compares in mask registers
+__attribute__((target("avx2,avx512f,avx512bw,avx512vl")))
+inline std::uint32_t propagate_lanes_avx512(std::uint16_t *masks){
+  return propagate_lanes_body(masks);
+}
+
+#endif // SIMD_SCAN_X86
+
+
+
+typedef std::uint32_t (*lane_kernel)(std::uint16_t *);
+
+// pick_lane_kernel() returns the fastest propagation kernel the CPU supports
+inline lane_kernel pick_lane_kernel(){
+#ifdef SIMD_SCAN_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vl")){
+    return propagate_lanes_avx512;
+  }
+  if(__builtin_cpu_supports("avx2")){
+    return propagate_lanes_avx2;
+  }
+#endif
+  return propagate_lanes_generic;
+}
+
+
+
+// propagate_lanes(masks) is propagate_lanes_body() on the kernel picked for this CPU
+
+// requires: masks must hold 81 * LANES masks
+inline std::uint32_t propagate_lanes(std::uint16_t *masks){
+  static const lane_kernel kernel = pick_lane_kernel();
+  return kernel(masks);
+}
+
+}
+
+
+
+// lane_solver solves 9x9 boards simd::LANES at a time (see above)
+class lane_solver{
+  public:
+  static constexpr int LANES = simd::LANES;
+  static constexpr int CELLS = 81;
+
+  // boards finished by solver<3> since the lane_solver was made
+  long guessed;
+
+  lane_solver() : guessed(0){}
+
+
+
+  // solve(boards, count, solved) solves count boards of CELLS row-major cells (0 for an
+  // empty cell) stored one after the other in boards, in place, and sets solved[k] to
+  // whether board k has a solution. Boards without one are left as they were
+
+  // requires: 0 <= count <= LANES, boards must hold count * CELLS values and solved count
+
+  // time: O(c) vector propagation plus a search for each board that needs one
+  void solve(int *boards, int count, bool *solved){
+    for(int cell = 0; cell < CELLS; ++cell){
+      for(int k = 0; k < LANES; ++k){
+        const int val = k < count ? boards[k * CELLS + cell] : 0;
+        // a number out of range leaves no candidate, which marks the board contradictory
+        masks[cell * LANES + k] = val == 0 ? 0x1ff : val > 0 && val <= 9 ? 1 << (val - 1) : 0;
+      }
+    }
+    const std::uint32_t dead = simd::propagate_lanes(masks);
+    int cells[CELLS];
+    for(int k = 0; k < count; ++k){
+      solved[k] = false;
+      if(dead & (1u << k)){
+        continue;
+      }
+      bool complete = true;
+      for(int cell = 0; cell < CELLS; ++cell){
+        const std::uint16_t mask = masks[cell * LANES + k];
+        const bool single = !(mask & (mask - 1));
+        cells[cell] = single ? __builtin_ctz(mask) + 1 : 0;
+        complete = complete && single;
+      }
+      if(!complete){
+        ++guessed;
+        if(!fallback.load(cells) || !fallback.solve()){
+          continue;
+        }
+        fallback.store(cells);
+      }
+      memcpy(boards + k * CELLS, cells, sizeof(cells));
+      solved[k] = true;
+    }
+  }
+
+
+
+  private:
+  std::uint16_t masks[CELLS * LANES];
+  solver<3> fallback;
+};
+
+}
+
+#endif // LANE_SOLVER_H
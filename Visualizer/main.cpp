@@ -1,12 +1,30 @@
 #include "mainwindow.h"
 #include <QApplication>
+#include <cstdlib>
+#include <cstring>
 
 //sudoku::matrix mat();
 
+// usage: Visualizer [--fps n] [--steps n] [--instant]
+//   --fps n      redraw the board n times a second while solving (default 60)
+//   --steps n    show at most n solver steps per redraw (default 8)
+//   --instant    do not animate the solve, just show the solution
+
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    int fps = 60, steps = 8;
+    for (int k = 1; k < argc; ++k)
+    {
+        if (!strcmp(argv[k], "--fps") && k + 1 < argc)
+            fps = atoi(argv[++k]);
+        else if (!strcmp(argv[k], "--steps") && k + 1 < argc)
+            steps = atoi(argv[++k]);
+        else if (!strcmp(argv[k], "--instant"))
+            steps = 0;
+    }
     MainWindow w;
+    w.set_animation(fps, steps);
     w.show();
 
     return a.exec();
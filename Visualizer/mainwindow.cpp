@@ -1,27 +1,27 @@
 #include "mainwindow.h"
 #include "ui_mainwindow.h"
 #include "backtracking_solver.h"
+#include <QFileDialog>
+#include <QHeaderView>
+#include <climits>
+#include <vector>
 #include <unistd.h>
 #include <cstdbool>
 #include <stdlib.h>
 
-sudoku::matrix matx;
-
-#define DIM 9
-#define BOX_DIM 3
-
-struct coordinate{
-  int row;
-  int column;
-};
-
-const struct coordinate GRID_FULL = {DIM, DIM};
+sudoku::matrix matx(time(NULL));
 
 MainWindow::MainWindow(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::MainWindow)
+    ui(new Ui::MainWindow),
+    frame_timer(new QTimer(this)),
+    replay_timer(new QTimer(this)),
+    replaying(false)
 {
     ui->setupUi(this);
+    connect(frame_timer, &QTimer::timeout, this, &MainWindow::drain_steps);
+    connect(replay_timer, &QTimer::timeout, this, &MainWindow::play_trace);
+    set_animation(60, 8);
     matx.new_puzzle();
     for (int i = 0; i < 9; ++i)
     {
@@ -123,53 +123,92 @@ void MainWindow::on_pb00_9_clicked()
     click__on_pb(9);
 }
 
-bool MainWindow::sudoku_solver_wrapper(int curr_row, int curr_column){
-  assert(matx.obj);
-  assert(curr_row >= 0);
-  assert(curr_row < DIM);
-  assert(curr_column >= 0);
-  assert(curr_column < DIM);
-
-  struct coordinate empty_posn = get_empty_posn(matx.obj, curr_row, curr_column);
-
-  if(coordinates_equal(empty_posn, GRID_FULL)){
-    return true;
-  }
-
-  const int row = empty_posn.row;
-  const int col = empty_posn.column;
-  for(int num = 1; num <= DIM; ++num){
-    if(is_valid(matx.obj, row, col, num)){
-      matx.obj[row][col] = num;
-      QTableWidgetItem* Cell = ui->table->item(row, col);
-      Cell->setForeground(QBrush(QColor(Qt::red)));
-      QString str = "";
-      str += '0' + matx.read(row,col);
-      const QString cstr = str;
-      Cell->setText(cstr);
-      QFont font;
-      font.setBold(true);
-      Cell->setFont(font);
-      repaint();
-      //show();
-      //usleep(100);
-      if(sudoku_solver_wrapper(row, col)){
-        return true;
-      }
-      matx.obj[row][col] = 0;
-      str = "";
-      const QString cstr_2 = str;
-      Cell->setText(cstr_2);
-      repaint();
-      //show();
-      //usleep(100000);
+// paint_step(Cell, val) draws a number the solver placed in red, or blanks the cell if
+// val is 0
+
+static void paint_step(QTableWidgetItem* Cell, int val)
+{
+    if (!val)
+    {
+        Cell->setText("");
+        return;
     }
-  }
-  return false;
+    QFont font;
+    font.setBold(true);
+    Cell->setForeground(QBrush(QColor(Qt::red)));
+    QString str = "";
+    str += val < 10 ? '0' + val : 'A' + val - 10;
+    const QString cstr = str;
+    Cell->setText(cstr);
+    Cell->setFont(font);
 }
 
-void MainWindow::on_New_Board_clicked(){
-    matx.new_puzzle();
+// set_animation(frames_per_second, steps_per_frame) sets how often the board is redrawn
+// during a solve or a replay and how many solver steps one redraw of a solve takes in at
+// most. With steps_per_frame 0 the solve is not animated and runs at full speed
+
+void MainWindow::set_animation(int frames_per_second, int steps_per_frame)
+{
+    frame_timer->setInterval(1000 / std::max(1, std::min(frames_per_second, 1000)));
+    replay_timer->setInterval(frame_timer->interval());
+    this->steps_per_frame = std::max(0, steps_per_frame);
+}
+
+// drain_steps() runs once per frame during a solve: it applies the queued solver steps
+// to the board as shown, redraws only the cells that changed, and draws the result once
+// the solver has finished and every step has been shown
+
+void MainWindow::drain_steps()
+{
+    // read before the queue, so that no step queued before the end is missed
+    const bool ended = worker.finished();
+    bool changed[sudoku::solve_worker::CELLS] = {};
+    sudoku::step_event step;
+    int popped = 0;
+    while (popped < steps_per_frame && worker.steps.pop(step))
+    {
+        shown[step.cell] = step.val;
+        changed[step.cell] = true;
+        ++popped;
+    }
+    for (int cell = 0; cell < sudoku::solve_worker::CELLS; ++cell)
+    {
+        if (changed[cell])
+            paint_step(ui->table->item(cell / 9, cell % 9), shown[cell]);
+    }
+    if (!ended || (steps_per_frame && popped == steps_per_frame))
+        return;
+
+    frame_timer->stop();
+    int cells[sudoku::solve_worker::CELLS];
+    if (worker.result(cells))
+    {
+        for (int cell = 0; cell < sudoku::solve_worker::CELLS; ++cell)
+        {
+            if (shown[cell] != cells[cell])
+                paint_step(ui->table->item(cell / 9, cell % 9), cells[cell]);
+            shown[cell] = cells[cell];
+            matx.write(cell / 9, cell % 9, cells[cell]);
+        }
+        ui->label->setText("solved!!");
+    } else{
+        ui->label->setText("no solution");
+    }
+}
+
+// stop_solving() abandons a running solve and its steps not yet shown
+
+void MainWindow::stop_solving()
+{
+    frame_timer->stop();
+    worker.cancel();
+    worker.steps.clear();
+}
+
+// show_board() draws the board of matx, givens on blue
+
+void MainWindow::show_board()
+{
     for (int i = 0; i < 9; ++i)
     {
         for (int j = 0; j < 9; ++j)
@@ -198,26 +237,33 @@ void MainWindow::on_New_Board_clicked(){
     }
 }
 
+void MainWindow::on_New_Board_clicked(){
+    stop_solving();
+    stop_replay();
+    matx.new_puzzle();
+    show_board();
+}
+
 void MainWindow::on_solve_clicked()
 {
+    if (frame_timer->isActive())
+        return;
+    stop_replay();
     matx.init();
-    sudoku_solver_wrapper(0, 0);
-    /*for (int i = 0; i < 9; ++i)
-	{
+    int cells[sudoku::solve_worker::CELLS];
+    for (int i = 0; i < 9; ++i)
+    {
         for (int j = 0; j < 9; ++j)
-		{
-			QTableWidgetItem* Cell = ui->table->item(i, j);
-			QString str = "";
-            str += '0' + matx.read(i,j);
-			const QString cstr = str;
-			Cell->setText(cstr);
-            show();
-		}
-    }*/
+            cells[i * 9 + j] = shown[i * 9 + j] = matx.read(i, j);
+    }
+    worker.start(cells, steps_per_frame > 0);
+    frame_timer->start();
 }
 
 void MainWindow::on_pushButton_clicked()
 {
+    stop_solving();
+    stop_replay();
     matx.reset();
     for (int i = 0; i < 9; ++i)
     {
@@ -235,3 +281,123 @@ void MainWindow::on_pushButton_clicked()
         }
     }
 }
+
+// resize_board(side) makes the table side x side cells, adding the cells it lacks and
+// shrinking them to keep the board its size
+
+void MainWindow::resize_board(int side)
+{
+    ui->table->setRowCount(side);
+    ui->table->setColumnCount(side);
+    ui->table->horizontalHeader()->setMinimumSectionSize(std::min(40, 360 / side));
+    for (int i = 0; i < side; ++i)
+    {
+        ui->table->setColumnWidth(i, 360 / side);
+        ui->table->setRowHeight(i, 270 / side);
+        for (int j = 0; j < side; ++j)
+        {
+            if (!ui->table->item(i, j))
+                ui->table->setItem(i, j, new QTableWidgetItem());
+        }
+    }
+}
+
+// show_replay() draws the board of the trace being replayed as it is at the current
+// frame: givens on blue, numbers the search has placed in red
+
+void MainWindow::show_replay()
+{
+    const int side = player.board_side();
+    QFont font;
+    font.setBold(true);
+    for (int cell = 0; cell < player.board_cells(); ++cell)
+    {
+        QTableWidgetItem* Cell = ui->table->item(cell / side, cell % side);
+        if (player.given(cell))
+        {
+            QString str = "";
+            str += player.read(cell) < 10 ? '0' + player.read(cell) : 'A' + player.read(cell) - 10;
+            const QString cstr = str;
+            Cell->setText(cstr);
+            Cell->setForeground(QBrush(QColor(Qt::black)));
+            Cell->setFont(font);
+            Cell->setBackgroundColor(QColor(122,122,235));
+        }
+        else
+        {
+            Cell->setBackgroundColor(QColor(255,255,255));
+            paint_step(Cell, player.read(cell));
+        }
+    }
+    ui->scrub->setValue(static_cast<int>(player.frame()));
+}
+
+// stop_replay() ends a replay and puts the board of matx back
+
+void MainWindow::stop_replay()
+{
+    if (!replaying)
+        return;
+    replay_timer->stop();
+    replaying = false;
+    resize_board(9);
+    show_board();
+}
+
+void MainWindow::on_Replay_clicked()
+{
+    const QString path = QFileDialog::getOpenFileName(this, "Replay trace");
+    if (path.isEmpty())
+        return;
+    stop_solving();
+    if (!player.load(path.toStdString().c_str()))
+    {
+        stop_replay();
+        ui->label->setText("not a trace");
+        return;
+    }
+    replaying = true;
+    resize_board(player.board_side());
+    ui->scrub->setRange(0, static_cast<int>(std::min<long>(player.frames(), INT_MAX)));
+    show_replay();
+    ui->label->setText("replay");
+    replay_timer->start();
+}
+
+// on_scrub_sliderMoved(frame) jumps the replay to frame, and plays on from there
+
+void MainWindow::on_scrub_sliderMoved(int frame)
+{
+    if (!replaying)
+        return;
+    player.seek(frame);
+    show_replay();
+    replay_timer->start();
+}
+
+// play_trace() runs once per frame during a replay: it plays the number of steps the
+// speed box asks for and redraws only the cells that changed
+
+void MainWindow::play_trace()
+{
+    const int side = player.board_side();
+    std::vector<bool> changed(player.board_cells());
+    int cell, val;
+    int played = 0;
+    while (played < ui->speed->value() && player.next(cell, val))
+    {
+        changed[cell] = true;
+        ++played;
+    }
+    for (cell = 0; cell < player.board_cells(); ++cell)
+    {
+        if (changed[cell])
+            paint_step(ui->table->item(cell / side, cell % side), player.read(cell));
+    }
+    ui->scrub->setValue(static_cast<int>(player.frame()));
+    if (player.frame() == player.frames())
+    {
+        replay_timer->stop();
+        ui->label->setText("replayed");
+    }
+}
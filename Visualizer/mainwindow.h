@@ -5,7 +5,10 @@
 #include <QLabel>
 #include <QString>
 #include <QTableWidget>
+#include <QTimer>
 #include "include.h"
+#include "solve_worker.h"
+#include "solve_trace.h"
 
 namespace Ui {
 class MainWindow;
@@ -18,6 +21,7 @@ class MainWindow : public QMainWindow
 public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
+    void set_animation(int frames_per_second, int steps_per_frame);
 
 private slots:
     void on_pb00_1_clicked();
@@ -33,16 +37,34 @@ private slots:
 
     void on_solve_clicked();
 
-    bool sudoku_solver_wrapper(int curr_row, int curr_col);
+    void drain_steps();
 
     void on_New_Board_clicked();
 
     void on_pushButton_clicked();
 
+    void on_Replay_clicked();
+
+    void on_scrub_sliderMoved(int frame);
+
+    void play_trace();
+
 private:
     Ui::MainWindow *ui;
     int Column, Row;
+    sudoku::solve_worker worker;
+    QTimer *frame_timer;
+    int steps_per_frame;
+    int shown[sudoku::solve_worker::CELLS];
+    sudoku::trace_player player;
+    QTimer *replay_timer;
+    bool replaying;
     void click__on_pb(int num);
+    void stop_solving();
+    void show_board();
+    void resize_board(int side);
+    void show_replay();
+    void stop_replay();
 };
 
 #endif // MAINWINDOW_H
@@ -1,5 +1,4 @@
 #include "matrix.h"
-#include "backtracking_solver.h"
 #include <cassert>
 
 #define DIM 9
@@ -12,7 +11,6 @@ struct coordinate{
 
 const struct coordinate GRID_FULL = {DIM, DIM};
 
-
 void sudoku::matrix::init()
 {
 	for (int i = 0; i < 9; ++i)
@@ -20,6 +18,7 @@ void sudoku::matrix::init()
 		this->row[i] = this->col[i] = 0;
 		this->block[i/3][i%3] = 0;
 	}
+	this->consistent = true;
 	for (int i = 0; i < 9; ++i)
 	{
 		for (int j = 0; j < 9; ++j)
@@ -27,6 +26,8 @@ void sudoku::matrix::init()
 			if(this->obj[i][j])
 			{
 				int sig = (1 << (obj[i][j] - 1));
+				if ((this->row[i] | this->col[j] | this->block[i/3][j/3]) & sig)
+					this->consistent = false;
 				this->row[i] |= sig;
 				this->col[j] |= sig;
 				this->block[i/3][j/3] |= sig;
@@ -35,6 +36,10 @@ void sudoku::matrix::init()
 			else this->ne[i][j] = 0;
 		}
 	}
+    int cells[81];
+    for (int cell = 0; cell < 81; ++cell)
+        cells[cell] = this->obj[cell / 9][cell % 9];
+    this->engine.load(cells);
 }
 
 int sudoku::matrix::input(int (*mat)[10])
@@ -49,12 +54,25 @@ int sudoku::matrix::input(int (*mat)[10])
     return 1;
 }
 
-sudoku::matrix::matrix(int (*mat)[10]):ra()
+// order_seed(seed) returns the seed of the random orders of dfs() in a matrix seeded
+// with seed: a splitmix64 step away from it, so that they come from another stream than
+// the puzzles of new_puzzle()
+static std::uint64_t order_seed(std::uint64_t seed)
+{
+    std::uint64_t z = seed ^ 0x632be59bd9b4e019ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+// matrix(mat, seed) and matrix(seed) fix the random choices of new_puzzle() and dfs()
+// by seed (see seed())
+sudoku::matrix::matrix(int (*mat)[10], std::uint64_t seed):maker(seed), ra(order_seed(seed))
 {
 	input(mat);
 }
 
-sudoku::matrix::matrix()
+sudoku::matrix::matrix(std::uint64_t seed):maker(seed), ra(order_seed(seed))
 {
     for (int i = 0; i < 9; ++i)
     {
@@ -71,26 +89,39 @@ sudoku::matrix::matrix()
     }
 }
 
-int sudoku::matrix::dfs(int ni, int nj)
+// dfs_search(ni, nj, depth, counter) is dfs(ni, nj) with depth cells already filled in
+// by the search, reporting to counter, which may halt it. Cells are taken in a fixed
+// order, so only the candidate checks are timed
+template <class COUNTER>
+int sudoku::matrix::dfs_search(int ni, int nj, int depth, COUNTER &counter)
 {
 	// std::cout << '(' << ni << ',' << nj << ')' << std::endl;
 	if (this->obj[ni][nj])
 	{
 		if (nj+1 < 9)
-			return dfs(ni, nj+1);
+			return dfs_search(ni, nj+1, depth, counter);
 		else if (ni+1 < 9)
-			return dfs(ni+1, 0);
+			return dfs_search(ni+1, 0, depth, counter);
 		else
 			return 1;
 	}
 	else
 	{
+		counter.node(depth);
+		if (counter.halt())
+			return -1;
+		std::uint64_t since = counter.start();
 		int sig = this->row[ni] | this->col[nj] | this->block[ni/3][nj/3];
+		counter.checked(since);
 		// std::cout << sig << std::endl;
+		// copy the order, since the calls below draw new ones into ra
+		int order[9];
 		this->ra.narray();
+		for (int i = 0; i < 9; ++i)
+			order[i] = this->ra.read(i);
 		for (int i = 0; i < 9; ++i)
 		{
-			int ri = this->ra.read(i);
+			int ri = order[i];
 			int sign = (1<<(ri-1));
 			// std::cout << i;
 			if (!(sig & sign))
@@ -100,14 +131,15 @@ int sudoku::matrix::dfs(int ni, int nj)
 				this->row[ni] |= sign;
 				this->col[nj] |= sign;
 				this->block[ni/3][nj/3] |= sign;
+				counter.guessed();
 				if (nj+1 < 9)
 				{
-					if (dfs(ni, nj+1) > 0)
+					if (dfs_search(ni, nj+1, depth+1, counter) > 0)
 						return 1;
 				}
 				else if (ni+1 < 9)
 				{
-					if (dfs(ni+1, 0) > 0)
+					if (dfs_search(ni+1, 0, depth+1, counter) > 0)
 						return 1;
 				}
 				else
@@ -118,46 +150,176 @@ int sudoku::matrix::dfs(int ni, int nj)
 				this->row[ni] ^= sign;
 				this->col[nj] ^= sign;
 				this->block[ni/3][nj/3] ^= sign;
+				counter.undone(1);
 			}
 		}
 		return -1;
 	}
 }
 
+int sudoku::matrix::dfs(int ni, int nj)
+{
+    no_counter counter(NULL);
+    return dfs_search(ni, nj, 0, counter);
+}
+
+
+// candidates(i, j) returns the bitmask of numbers (bit n-1 for number n) that can
+// still be placed at (i, j) by the solver
+
+// time: O(1)
+int sudoku::matrix::candidates(int i, int j)
+{
+    return this->engine.candidates(i * 9 + j);
+}
+
+// set_selection(mode, tie) chooses how next_cell() picks a cell; call it before
+// init()/solve()
+void sudoku::matrix::set_selection(select_mode mode, tie_break tie)
+{
+    this->engine.set_selection(mode, tie);
+}
 
+// next_cell(start_row, start_col) returns the empty cell the solver branches on
+// next, or GRID_FULL if there is none (see solver::next_cell)
+struct coordinate sudoku::matrix::next_cell(int start_row, int start_col)
+{
+    int cell = this->engine.next_cell(start_row * 9 + start_col);
+    if (cell == solver<BOX_DIM>::FULL)
+        return GRID_FULL;
+    struct coordinate retval = {cell / 9, cell % 9};
+    return retval;
+}
+
+// assign(i, j, val) places val at (i, j) through the solver, which records the
+// cell on its trail so that undo() can take it back
+void sudoku::matrix::assign(int i, int j, int val)
+{
+    this->engine.assign(i * 9 + j, val);
+    this->obj[i][j] = val;
+}
+
+// undo(mark) clears every cell assigned since trail_size() returned mark
+void sudoku::matrix::undo(int mark)
+{
+    for (int k = mark; k < this->engine.trail_size(); ++k)
+    {
+        int cell = this->engine.trail_cell(k);
+        this->obj[cell / 9][cell % 9] = 0;
+    }
+    this->engine.undo(mark);
+}
+
+int sudoku::matrix::trail_size()
+{
+    return this->engine.trail_size();
+}
+
+int sudoku::matrix::trail_cell(int k)
+{
+    return this->engine.trail_cell(k);
+}
+
+// propagate() fills in the naked and hidden singles (see solver::propagate) and
+// copies them into obj, returning false if the board is contradictory
+bool sudoku::matrix::propagate()
+{
+    int mark = this->engine.trail_size();
+    bool ok = this->engine.propagate();
+    for (int k = mark; k < this->engine.trail_size(); ++k)
+    {
+        int cell = this->engine.trail_cell(k);
+        this->obj[cell / 9][cell % 9] = this->engine.read(cell);
+    }
+    return ok;
+}
+
+
+// sudoku_solver_wrapper(curr_row, curr_column) solves the board from the given position
+// onwards with solver::search and copies the result into obj
+
+// requires: init() has been called since the last change made through write()
 bool sudoku::matrix::sudoku_solver_wrapper(int curr_row, int curr_column){
-  assert(this->obj);
   assert(curr_row >= 0);
   assert(curr_row < DIM);
   assert(curr_column >= 0);
   assert(curr_column < DIM);
 
-  struct coordinate empty_posn = get_empty_posn(this->obj, curr_row, curr_column);
-
-  if(coordinates_equal(empty_posn, GRID_FULL)){
-    return true;
+  const bool solved = this->engine.search(curr_row * DIM + curr_column);
+  for(int cell = 0; cell < DIM * DIM; ++cell){
+    this->obj[cell / DIM][cell % DIM] = this->engine.read(cell);
   }
+  return solved;
+}
 
-  const int row = empty_posn.row;
-  const int col = empty_posn.column;
-  for(int num = 1; num <= DIM; ++num){
-    if(is_valid(this->obj, row, col, num)){
-      this->obj[row][col] = num;
-      if(sudoku_solver_wrapper(row, col)){
-        return true;
-      }
-      this->obj[row][col] = 0;
+
+bool sudoku::matrix::solve()
+{
+    init();
+    //dfs(0, 0);
+    return this->consistent && sudoku_solver_wrapper(0, 0);
+}
+
+// solve(stats) is solve() that also clears stats and fills it in (see
+// solver::solve(stats))
+bool sudoku::matrix::solve(sudoku::search_stats *stats)
+{
+    init();
+    stats->clear();
+    const bool solved = this->consistent && this->engine.solve(stats);
+    for (int cell = 0; cell < 81; ++cell)
+        this->obj[cell / 9][cell % 9] = this->engine.read(cell);
+    return solved;
+}
+
+// solve(options, stats) is solve(stats) within the budget of options (see
+// solver::solve(options, stats)); obj is left as it was unless the board is solved
+sudoku::solve_result sudoku::matrix::solve(const sudoku::solve_options &options, sudoku::search_stats *stats)
+{
+    init();
+    stats->clear();
+    if (!this->consistent)
+        return SOLVE_UNSOLVABLE;
+    const solve_result result = this->engine.solve(options, stats);
+    if (result == SOLVE_SOLVED)
+    {
+        for (int cell = 0; cell < 81; ++cell)
+            this->obj[cell / 9][cell % 9] = this->engine.read(cell);
     }
-  }
-  return false;
+    return result;
 }
 
 
-void sudoku::matrix::solve()
+// solve_dfs() solves the board in obj with dfs(), the original search that tries the
+// numbers of each cell in the random order of rdarray, and returns false if it cannot
+bool sudoku::matrix::solve_dfs()
 {
     init();
-    //dfs(0, 0);
-    sudoku_solver_wrapper(0, 0);
+    return this->consistent && dfs(0, 0) > 0;
+}
+
+// solve_dfs(stats) is solve_dfs() that also clears stats and fills it in
+bool sudoku::matrix::solve_dfs(sudoku::search_stats *stats)
+{
+    init();
+    stats->clear();
+    search_counter counter(stats);
+    return this->consistent && dfs_search(0, 0, 0, counter) > 0;
+}
+
+// solve_dfs(options, stats) is solve_dfs(stats) within the budget of options (see
+// solve_options.h); the search undoes its guesses as it gives up, so obj is left as it
+// was unless the board is solved
+sudoku::solve_result sudoku::matrix::solve_dfs(const sudoku::solve_options &options, sudoku::search_stats *stats)
+{
+    init();
+    stats->clear();
+    if (!this->consistent)
+        return SOLVE_UNSOLVABLE;
+    budget_counter counter(stats, options);
+    const bool solved = dfs_search(0, 0, 0, counter) > 0;
+    stats->nodes = counter.nodes_searched();
+    return solved ? SOLVE_SOLVED : counter.halted() ? SOLVE_EXHAUSTED : SOLVE_UNSOLVABLE;
 }
 
 int sudoku::matrix::output(int (*mat)[10])
@@ -203,51 +365,21 @@ void sudoku::matrix::empty()
     }
 }
 
-/*
-int dfs(int ni, int nj, int nres)
+// count_solutions(limit) returns how many solutions the board in obj has, counting no
+// further than limit (see solver::count_solutions); obj is left as it was
+int sudoku::matrix::count_solutions(int limit)
 {
-	int res = nres;
-
-	else if (obj[ni][nj] > 0)
-	{
-		if (nj+1 < 9) return res + dfs(ni, nj+1);
-		else if (ni+1 < 9) return res + dfs(ni+1, 0);
-		else return res + 1;
-	}
-	else
-	{
-		int sig = row[ni] | col[nj] | block[ni/3][nj/3];
-		for (int i = 0; i < 9; ++i)
-		{
-			int sign = (1<<i);
-			if (!(sig&sign))
-			{
-				obj[ni][nj] = i+1;
-				row[ni] |= sign;
-				col[nj] |= sign;
-				block[ni/3][nj/3] |= sign;
-				if (nj+1 < 9) res += dfs(ni, nj+1);
-				else if (ni+1 <9) res += dfs(ni+1, 0);
-				else res += 1;
-				obj[ni][nj] = 0;
-				row[ni] ^= sign;
-				col[nj] ^= sign;
-				block[ni/3][nj/3] ^= sign;
-
-				if (res >= 2) return res;
-			}
-		}
-		return 0;
-	}
+    init();
+    if (!this->consistent)
+        return 0;
+    return this->engine.count_solutions(limit);
 }
 
-bool one_answer()
+// one_answer() returns true if the board in obj has exactly one solution
+bool sudoku::matrix::one_answer()
 {
-	init();
-	if (dfs(0, 0, 0) == 1) return true;
-	else return false;
+    return count_solutions(2) == 1;
 }
-*/
 
 bool sudoku::matrix::you_win()
 {
@@ -278,25 +410,23 @@ bool sudoku::matrix::you_win()
 	return true;
 }
 
+// new_puzzle() replaces the board with a random puzzle that has a unique solution,
+// about as many clues as a newspaper puzzle and rotational symmetry
 void sudoku::matrix::new_puzzle()
 {
-	empty();
+    int cells[81];
+    this->maker.generate(cells, 32, SYMMETRY_ROTATIONAL);
+    for (int cell = 0; cell < 81; ++cell)
+        this->obj[cell / 9][cell % 9] = cells[cell];
     init();
-    dfs(0, 0);
-	srand(time(NULL));
-    int rdbox = rand()%10 + 40;
-	for (int k = 0; k < rdbox; ++k)
-	{
-		int i = rand()%9;
-		int j = rand()%9;
-		while(!obj[i][j])
-		{
-			i = rand()%9;
-			j = rand()%9;
-		}
-		obj[i][j] = 0;
-	}
-	init();
+}
+
+// seed(seed) restarts the random choices of new_puzzle() and dfs() from seed, so the
+// same seed gives the same puzzles
+void sudoku::matrix::seed(std::uint64_t seed)
+{
+    this->maker.reseed(seed);
+    this->ra.seed(order_seed(seed));
 }
 
 void sudoku::matrix::reset()
@@ -1,23 +1,43 @@
 #ifndef _MATRIX
 	#include "rdarray.h"
+	#include "solver.h"
+	#include "generator.h"
 	
 	#define _MATRIX
 #endif
 
+struct coordinate;
+
 namespace sudoku{
 	class matrix{
 		public:
 		bool you_win();
         void write(int i, int j, int val);
 		void new_puzzle();
-		void solve();
+        void seed(std::uint64_t seed);
+		bool solve();
+        bool solve(sudoku::search_stats *stats);
+        sudoku::solve_result solve(const sudoku::solve_options &options, sudoku::search_stats *stats);
+        bool solve_dfs();
+        bool solve_dfs(sudoku::search_stats *stats);
+        sudoku::solve_result solve_dfs(const sudoku::solve_options &options, sudoku::search_stats *stats);
+        int count_solutions(int limit);
+        bool one_answer();
         bool sudoku_solver_wrapper(int curr_row, int curr_col);
+        int candidates(int i, int j);
+        void set_selection(select_mode mode, tie_break tie);
+        struct coordinate next_cell(int start_row, int start_col);
+        void assign(int i, int j, int val);
+        bool propagate();
+        void undo(int mark);
+        int trail_size();
+        int trail_cell(int k);
         void reset();
 		int read(int i, int j);
 		int output(int (*mat)[10]);
 		int input(int (*mat)[10]);
-		matrix(int (*mat)[10]);
-        matrix();
+		matrix(int (*mat)[10], std::uint64_t seed);
+        explicit matrix(std::uint64_t seed);
         int obj[10][10];
         void init();
 
@@ -26,8 +46,13 @@ namespace sudoku{
 		int col[10];
 		int block[5][5];
 		int ne[10][10];
+        bool consistent;
+        sudoku::solver<3> engine;
+        sudoku::generator<3> maker;
 		sudoku::rdarray ra;
 		int dfs(int ni, int nj);
+        template <class COUNTER>
+        int dfs_search(int ni, int nj, int depth, COUNTER &counter);
         void empty();
 	};
 }
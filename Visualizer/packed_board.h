@@ -0,0 +1,238 @@
+#ifndef PACKED_BOARD_H
+#define PACKED_BOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Compact boards for holding many puzzles in memory. A board is stored as a fixed-size
+// record of BITS bits per cell, just enough for the numbers 0 to SIDE: 4 bits for 9x9
+// (41 bytes instead of the 324 of an int array, or 400 of an int[10][10] grid), 5 for
+// 16x16 and 25x25 (160 and 391 bytes) and 6 for 36x36. The records have no padding, so
+// a packed_boards container is one contiguous run of them.
+
+namespace sudoku{
+
+template <int BOX_DIM>
+class packed_board{
+  public:
+  static constexpr int SIDE = BOX_DIM * BOX_DIM;
+  static constexpr int CELLS = SIDE * SIDE;
+  static constexpr int BITS = SIDE < 16 ? 4 : SIDE < 32 ? 5 : 6;
+  static constexpr int BYTES = (CELLS * BITS + 7) / 8;
+  static constexpr unsigned MASK = (1u << BITS) - 1;
+
+  // the packed cells, BITS bits each from the lowest bit of bytes[0] up
+  std::uint8_t bytes[BYTES];
+
+
+
+  // pack(cells) stores the row-major board in cells, and unpack(cells) writes it back out
+
+  // requires: cells must hold CELLS numbers from 0 to SIDE
+
+  // time: O(n) where n is CELLS
+  void pack(const int *cells){
+    if(BITS == 4){
+      for(int k = 0; k < CELLS / 2; ++k){
+        bytes[k] = static_cast<std::uint8_t>(cells[2 * k] | cells[2 * k + 1] << 4);
+      }
+      if(CELLS % 2){
+        bytes[BYTES - 1] = static_cast<std::uint8_t>(cells[CELLS - 1]);
+      }
+      return;
+    }
+    std::uint32_t bits = 0;
+    int count = 0;
+    int at = 0;
+    for(int cell = 0; cell < CELLS; ++cell){
+      bits |= static_cast<std::uint32_t>(cells[cell]) << count;
+      count += BITS;
+      while(count >= 8){
+        bytes[at++] = static_cast<std::uint8_t>(bits);
+        bits >>= 8;
+        count -= 8;
+      }
+    }
+    if(count){
+      bytes[at] = static_cast<std::uint8_t>(bits);
+    }
+  }
+
+  void unpack(int *cells) const{
+    if(BITS == 4){
+      for(int k = 0; k < CELLS / 2; ++k){
+        cells[2 * k] = bytes[k] & 15;
+        cells[2 * k + 1] = bytes[k] >> 4;
+      }
+      if(CELLS % 2){
+        cells[CELLS - 1] = bytes[BYTES - 1] & 15;
+      }
+      return;
+    }
+    std::uint32_t bits = 0;
+    int count = 0;
+    int at = 0;
+    for(int cell = 0; cell < CELLS; ++cell){
+      if(count < BITS){
+        bits |= static_cast<std::uint32_t>(bytes[at++]) << count;
+        count += 8;
+      }
+      cells[cell] = bits & MASK;
+      bits >>= BITS;
+      count -= BITS;
+    }
+  }
+
+
+
+  // pack_grid(grid) and unpack_grid(grid) are pack() and unpack() for the grids with a
+  // padding row and column used by backtracking_solver.h and matrix.h
+
+  // requires: grid must hold SIDE + 1 rows of SIDE + 1 numbers from 0 to SIDE
+  void pack_grid(const int (*grid)[SIDE + 1]){
+    int cells[CELLS];
+    for(int cell = 0; cell < CELLS; ++cell){
+      cells[cell] = grid[cell / SIDE][cell % SIDE];
+    }
+    pack(cells);
+  }
+
+  void unpack_grid(int (*grid)[SIDE + 1]) const{
+    int cells[CELLS];
+    unpack(cells);
+    for(int cell = 0; cell < CELLS; ++cell){
+      grid[cell / SIDE][cell % SIDE] = cells[cell];
+    }
+  }
+
+
+
+  // read(cell) returns the number at cell, or 0 if it is empty, and write(cell, val)
+  // sets it
+
+  // requires: 0 <= cell < CELLS, 0 <= val <= SIDE
+
+  // time: O(1)
+  int read(int cell) const{
+    const int bit = cell * BITS;
+    unsigned bits = bytes[bit / 8];
+    if(bit / 8 + 1 < BYTES){
+      bits |= static_cast<unsigned>(bytes[bit / 8 + 1]) << 8;
+    }
+    return bits >> bit % 8 & MASK;
+  }
+
+  void write(int cell, int val){
+    const int bit = cell * BITS;
+    const unsigned bits = (static_cast<unsigned>(val) & MASK) << bit % 8;
+    const unsigned keep = ~(MASK << bit % 8);
+    bytes[bit / 8] = static_cast<std::uint8_t>((bytes[bit / 8] & keep) | bits);
+    if(bit / 8 + 1 < BYTES){
+      bytes[bit / 8 + 1] = static_cast<std::uint8_t>((bytes[bit / 8 + 1] & keep >> 8) | bits >> 8);
+    }
+  }
+
+
+
+  bool operator==(const packed_board &other) const{
+    return memcmp(bytes, other.bytes, BYTES) == 0;
+  }
+
+  bool operator!=(const packed_board &other) const{
+    return !(*this == other);
+  }
+
+  // hasher hashes boards for unordered containers (64-bit FNV-1a)
+  struct hasher{
+    size_t operator()(const packed_board &board) const{
+      std::uint64_t hash = 0xcbf29ce484222325ULL;
+      for(int k = 0; k < BYTES; ++k){
+        hash = (hash ^ board.bytes[k]) * 0x100000001b3ULL;
+      }
+      return static_cast<size_t>(hash);
+    }
+  };
+};
+
+
+
+// packed_boards<BOX_DIM> is a growable array of packed boards stored back to back, for
+// corpora of millions of puzzles
+template <int BOX_DIM>
+class packed_boards{
+  public:
+  typedef packed_board<BOX_DIM> board_type;
+  static constexpr int CELLS = board_type::CELLS;
+  static_assert(sizeof(board_type) == board_type::BYTES, "packed boards must not be padded");
+
+
+
+  // push_back(cells) appends the row-major board in cells
+
+  // requires: cells must hold CELLS numbers from 0 to BOX_DIM^2
+
+  // time: O(n) amortised where n is CELLS
+  void push_back(const int *cells){
+    boards.resize(boards.size() + 1);
+    boards.back().pack(cells);
+  }
+
+  void push_back(const board_type &board){
+    boards.push_back(board);
+  }
+
+  // pop_back() removes the last board
+
+  // requires: size() > 0
+  void pop_back(){
+    boards.pop_back();
+  }
+
+  // unpack(k, cells) writes board k out into cells
+
+  // requires: k < size(), cells must hold CELLS values
+  void unpack(size_t k, int *cells) const{
+    boards[k].unpack(cells);
+  }
+
+  board_type &operator[](size_t k){
+    return boards[k];
+  }
+
+  const board_type &operator[](size_t k) const{
+    return boards[k];
+  }
+
+  // data() returns the first board; the others follow it without gaps
+  const board_type *data() const{
+    return boards.data();
+  }
+
+  size_t size() const{
+    return boards.size();
+  }
+
+  // bytes() returns the memory taken by the boards held
+  size_t bytes() const{
+    return boards.size() * sizeof(board_type);
+  }
+
+  void reserve(size_t count){
+    boards.reserve(count);
+  }
+
+  void clear(){
+    boards.clear();
+  }
+
+
+
+  private:
+  std::vector<board_type> boards;
+};
+
+}
+
+#endif // PACKED_BOARD_H
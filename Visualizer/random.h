@@ -0,0 +1,95 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include <cstdint>
+
+// Small, fast pseudo-random generator (xoshiro256**) kept per user instead of the
+// process-wide rand(), so threads never share or reseed each other's state. The state
+// is filled from the seed with splitmix64, so any seed (0 included) is a good one.
+
+namespace sudoku{
+
+class xoshiro256{
+  public:
+  typedef std::uint64_t result_type;
+
+  // xoshiro256(seed) starts the sequence fixed by seed
+  explicit xoshiro256(std::uint64_t seed = 0){
+    reseed(seed);
+  }
+
+
+
+  // reseed(seed) restarts the sequence fixed by seed
+
+  // time: O(1)
+  void reseed(std::uint64_t seed){
+    for(int k = 0; k < 4; ++k){
+      seed += 0x9e3779b97f4a7c15ULL;
+      std::uint64_t z = seed;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      state[k] = z ^ (z >> 31);
+    }
+  }
+
+
+
+  // operator()() returns the next 64 random bits
+
+  // time: O(1)
+  std::uint64_t operator()(){
+    const std::uint64_t result = rotl(state[1] * 5, 7) * 9;
+    const std::uint64_t t = state[1] << 17;
+    state[2] ^= state[0];
+    state[3] ^= state[1];
+    state[1] ^= state[2];
+    state[0] ^= state[3];
+    state[2] ^= t;
+    state[3] = rotl(state[3], 45);
+    return result;
+  }
+
+
+
+  // below(n) returns a uniformly distributed number in [0, n), by multiplying rather than
+  // dividing and retrying the rare draws that would bias the result
+
+  // requires: n > 0
+
+  // time: O(1) expected
+  std::uint32_t below(std::uint32_t n){
+    std::uint64_t product = ((*this)() >> 32) * n;
+    if(static_cast<std::uint32_t>(product) < n){
+      const std::uint32_t threshold = (0u - n) % n;
+      while(static_cast<std::uint32_t>(product) < threshold){
+        product = ((*this)() >> 32) * n;
+      }
+    }
+    return static_cast<std::uint32_t>(product >> 32);
+  }
+
+
+
+  // min() and max() make the generator usable with the <random> distributions
+  static constexpr result_type min(){
+    return 0;
+  }
+
+  static constexpr result_type max(){
+    return ~result_type(0);
+  }
+
+
+
+  private:
+  std::uint64_t state[4];
+
+  static std::uint64_t rotl(std::uint64_t x, int k){
+    return (x << k) | (x >> (64 - k));
+  }
+};
+
+}
+
+#endif // RANDOM_H
@@ -1,30 +1,36 @@
 #include "rdarray.h"
 
+// narray() draws a new random order of the numbers 1-9 with a Fisher-Yates shuffle of
+// the previous one
 void sudoku::rdarray::narray()
 {
-	srand(rdseed);
-	this->rdseed = rand();
-	int queue[10];
-	for (int i = 0; i < 9; ++i)
-	{
-		queue[i] = i+1;
-	}
-	for (int i = 0; i < 9; ++i)
+	for (int i = 8; i > 0; --i)
 	{
-		int stp = rand()%9;
-		while(!queue[stp])
-		{
-			stp ++;
-			stp %= 9;
-		}
-		this->array[i] = queue[stp];
-		queue[stp] = 0;
+		int j = this->random.below(i + 1);
+		int tmp = this->array[i];
+		this->array[i] = this->array[j];
+		this->array[j] = tmp;
 	}
 }
 
 sudoku::rdarray::rdarray()
 {
-	this->rdseed = time(NULL);
+	seed(time(NULL));
+}
+
+sudoku::rdarray::rdarray(std::uint64_t seed)
+{
+	this->seed(seed);
+}
+
+// seed(seed) restarts the orders from seed, so the same seed gives the same orders
+void sudoku::rdarray::seed(std::uint64_t seed)
+{
+	this->random.reseed(seed);
+	for (int i = 0; i < 9; ++i)
+	{
+		this->array[i] = i+1;
+	}
 	narray();
 }
 
@@ -1,6 +1,7 @@
 #ifndef _RDARRAY
-	#include <cstdlib>
+	#include <cstdint>
 	#include <time.h>
+	#include "random.h"
 	#define _RDARRAY
 #endif
 
@@ -8,11 +9,13 @@ namespace sudoku{
 	class rdarray{
 		public:
 			rdarray();
+			explicit rdarray(std::uint64_t seed);
+			void seed(std::uint64_t seed);
 			void narray();
 			int read(int i);
 
 		private:
 			int array[10];
-			int rdseed;
+			sudoku::xoshiro256 random;
 	};
 }
@@ -0,0 +1,160 @@
+#ifndef SEARCH_STATS_H
+#define SEARCH_STATS_H
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Counters of what a backtracking search did, for finding out why one puzzle takes a
+// thousand times longer than another. The searches are templated on a counter class:
+// stats_counter<false> does nothing and compiles away, so the plain entry points cost
+// exactly what they did, and the entry points that take a search_stats use
+// search_counter, which is stats_counter<true> unless SUDOKU_STATS is 0.
+
+// SUDOKU_STATS is 1 to collect the counters and 0 to compile them out; it defaults to
+// 0 in NDEBUG builds and to 1 otherwise
+#ifndef SUDOKU_STATS
+#ifdef NDEBUG
+#define SUDOKU_STATS 0
+#else
+#define SUDOKU_STATS 1
+#endif
+#endif
+
+namespace sudoku{
+
+struct search_stats{
+  // buckets of the depth histogram; the last one also counts every deeper node
+  static constexpr int DEPTHS = 128;
+  // the selection and check times are measured at one node in TIME_SAMPLE and scaled
+  // up, which keeps reading the clock out of most of the search
+  static constexpr long TIME_SAMPLE = 16;
+
+  // search nodes (calls of the recursive search)
+  long nodes;
+  // numbers written into cells, by branching or by propagation
+  long placements;
+  // placements that were guesses at a branching cell
+  long guesses;
+  // numbers taken back out of cells
+  long undos;
+  int max_depth;
+  long depth[DEPTHS];
+  // estimated time spent choosing the next cell and checking candidates, in CPU
+  // timestamp ticks on x86 and nanoseconds elsewhere
+  std::uint64_t select_ticks;
+  std::uint64_t check_ticks;
+
+  search_stats(){
+    clear();
+  }
+
+  // clear() zeroes every counter
+  void clear(){
+    memset(this, 0, sizeof(*this));
+  }
+};
+
+
+
+// ticks() returns a cheap, monotonic timestamp in the units of search_stats
+inline std::uint64_t ticks(){
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+
+
+template <bool ENABLED>
+class stats_counter;
+
+// the counter that counts nothing
+template <>
+class stats_counter<false>{
+  public:
+  explicit stats_counter(search_stats *){}
+  void node(int){}
+  bool halt(){
+    return false;
+  }
+  void placed(long){}
+  void guessed(){}
+  void undone(long){}
+  std::uint64_t start() const{
+    return 0;
+  }
+  void selected(std::uint64_t){}
+  void checked(std::uint64_t){}
+};
+
+// the counter that adds to a search_stats
+template <>
+class stats_counter<true>{
+  public:
+  // requires: stats must not be NULL
+  explicit stats_counter(search_stats *stats) : stats(stats){}
+
+  // halt() returns true to make the search give up before its next node; counters that
+  // keep a budget (see solve_options.h) override it
+  bool halt(){
+    return false;
+  }
+
+  // node(depth) counts a search node depth levels below the root
+  void node(int depth){
+    ++stats->nodes;
+    ++stats->depth[depth < search_stats::DEPTHS ? depth : search_stats::DEPTHS - 1];
+    if(depth > stats->max_depth){
+      stats->max_depth = depth;
+    }
+  }
+
+  void placed(long count){
+    stats->placements += count;
+  }
+
+  // guessed() counts one placement that is a guess
+  void guessed(){
+    ++stats->guesses;
+    ++stats->placements;
+  }
+
+  void undone(long count){
+    stats->undos += count;
+  }
+
+  // start() returns the time a selection or check begins, to hand to selected() or
+  // checked() when it ends, or 0 if the current node is not timed
+  std::uint64_t start() const{
+    return stats->nodes % search_stats::TIME_SAMPLE != 1 ? 0 : ticks();
+  }
+
+  void selected(std::uint64_t since){
+    if(since){
+      stats->select_ticks += (ticks() - since) * search_stats::TIME_SAMPLE;
+    }
+  }
+
+  void checked(std::uint64_t since){
+    if(since){
+      stats->check_ticks += (ticks() - since) * search_stats::TIME_SAMPLE;
+    }
+  }
+
+  private:
+  search_stats *stats;
+};
+
+typedef stats_counter<SUDOKU_STATS != 0> search_counter;
+typedef stats_counter<false> no_counter;
+
+}
+
+#endif // SEARCH_STATS_H
@@ -0,0 +1,257 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <cstdint>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define SIMD_SCAN_X86 1
+#endif
+
+// Whole-board candidate scan for boards whose number masks fit in 16 bits (9x9 and 16x16).
+// Each board row is handled as one vector of 16 lanes, one lane per column: the row's
+// mask is broadcast and ORed with the column masks and the block masks of the band, the
+// lane popcounts give the candidate counts, and vector compares and mins find the cells
+// with a single candidate and a cell with the fewest. The AVX2 kernel does a row per
+// instruction; SSE2 does it in two halves. The kernel is chosen once at runtime from the
+// CPU's features, and boards wider than 16 lanes fall back to the scalar loop.
+
+namespace sudoku{
+namespace simd{
+
+// board_scan_input describes the board to scan. grid must be readable for 16 bytes past
+// the start of its last row
+struct board_scan_input{
+  const std::uint16_t *row_used;
+  const std::uint16_t *col_used;
+  const std::uint16_t *box_used;
+  const std::uint8_t *grid;
+  int box_dim;
+  std::uint16_t all;
+};
+
+// board_scan_output receives, for every row i, the candidate masks of its cells in
+// cand[16 * i .. 16 * i + 15] and a bitmask of its empty cells with a single candidate
+// in singles[i]
+struct board_scan_output{
+  std::uint16_t *cand;
+  std::uint64_t *singles;
+};
+
+// NO_EMPTY_CELL is returned as the fewest candidates when the board is full
+const int NO_EMPTY_CELL = 0xff;
+
+
+
+// band_boxes(in, bands) fills bands[b][j] with the block mask covering column j of band b
+inline void band_boxes(const board_scan_input &in, std::uint16_t bands[][16]){
+  const int side = in.box_dim * in.box_dim;
+  for(int b = 0; b < in.box_dim; ++b){
+    for(int j = 0; j < 16; ++j){
+      bands[b][j] = j < side ? in.box_used[b * in.box_dim + j / in.box_dim] : 0;
+    }
+  }
+}
+
+
+
+// scan_scalar(in, out, best) is the portable kernel: it returns the fewest candidates of
+// any empty cell (NO_EMPTY_CELL if there is none) and sets best to the first such cell
+inline int scan_scalar(const board_scan_input &in, const board_scan_output &out, int &best){
+  const int side = in.box_dim * in.box_dim;
+  int fewest = NO_EMPTY_CELL;
+  best = -1;
+  for(int i = 0; i < side; ++i){
+    const int band = i / in.box_dim;
+    std::uint64_t singles = 0;
+    for(int j = 0; j < side; ++j){
+      const std::uint16_t cand = in.all & ~(in.row_used[i] | in.col_used[j] |
+                                             in.box_used[band * in.box_dim + j / in.box_dim]);
+      out.cand[16 * i + j] = cand;
+      if(in.grid[i * side + j]){
+        continue;
+      }
+      const int count = __builtin_popcount(cand);
+      if(count == 1){
+        singles |= std::uint64_t(1) << j;
+      }
+      if(count < fewest){
+        fewest = count;
+        best = i * side + j;
+      }
+    }
+    out.singles[i] = singles;
+  }
+  return fewest;
+}
+
+
+
+#ifdef SIMD_SCAN_X86
+
+// scan_sse2(in, out, best) is scan_scalar() with each row split over two 8-lane vectors
+__attribute__((target("sse2")))
+inline int scan_sse2(const board_scan_input &in, const board_scan_output &out, int &best){
+  const int side = in.box_dim * in.box_dim;
+  alignas(16) std::uint16_t cols[16] = {};
+  alignas(16) std::uint16_t bands[6][16];
+  alignas(16) std::uint16_t valid[16];
+  alignas(16) std::uint16_t counts[16][16];
+  for(int j = 0; j < 16; ++j){
+    cols[j] = j < side ? in.col_used[j] : 0;
+    valid[j] = j < side ? 0xffff : 0;
+  }
+  band_boxes(in, bands);
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i all = _mm_set1_epi16(static_cast<short>(in.all));
+  const __m128i none = _mm_set1_epi16(NO_EMPTY_CELL);
+  const __m128i one = _mm_set1_epi16(1);
+  const __m128i m1 = _mm_set1_epi16(0x5555), m2 = _mm_set1_epi16(0x3333);
+  const __m128i m4 = _mm_set1_epi16(0x0f0f), m8 = _mm_set1_epi16(0x001f);
+  __m128i fewest = none;
+  for(int i = 0; i < side; ++i){
+    const __m128i row = _mm_set1_epi16(static_cast<short>(in.row_used[i]));
+    const __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in.grid + i * side));
+    __m128i ones[2];
+    for(int h = 0; h < 2; ++h){
+      const __m128i used = _mm_or_si128(row, _mm_or_si128(
+          _mm_load_si128(reinterpret_cast<const __m128i *>(cols + 8 * h)),
+          _mm_load_si128(reinterpret_cast<const __m128i *>(bands[i / in.box_dim] + 8 * h))));
+      const __m128i cand = _mm_andnot_si128(used, all);
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(out.cand + 16 * i + 8 * h), cand);
+      __m128i c = _mm_sub_epi16(cand, _mm_and_si128(_mm_srli_epi16(cand, 1), m1));
+      c = _mm_add_epi16(_mm_and_si128(c, m2), _mm_and_si128(_mm_srli_epi16(c, 2), m2));
+      c = _mm_and_si128(_mm_add_epi16(c, _mm_srli_epi16(c, 4)), m4);
+      c = _mm_and_si128(_mm_add_epi16(c, _mm_srli_epi16(c, 8)), m8);
+      const __m128i cells = h ? _mm_unpackhi_epi8(g, zero) : _mm_unpacklo_epi8(g, zero);
+      const __m128i empty = _mm_and_si128(_mm_cmpeq_epi16(cells, zero),
+          _mm_load_si128(reinterpret_cast<const __m128i *>(valid + 8 * h)));
+      c = _mm_or_si128(_mm_and_si128(empty, c), _mm_andnot_si128(empty, none));
+      _mm_store_si128(reinterpret_cast<__m128i *>(counts[i] + 8 * h), c);
+      ones[h] = _mm_cmpeq_epi16(c, one);
+      fewest = _mm_min_epi16(fewest, c);
+    }
+    out.singles[i] = static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_packs_epi16(ones[0], ones[1])));
+  }
+  alignas(16) std::uint16_t lanes[8];
+  _mm_store_si128(reinterpret_cast<__m128i *>(lanes), fewest);
+  int result = NO_EMPTY_CELL;
+  for(int k = 0; k < 8; ++k){
+    result = lanes[k] < result ? lanes[k] : result;
+  }
+  best = -1;
+  const __m128i target = _mm_set1_epi16(static_cast<short>(result));
+  for(int i = 0; result != NO_EMPTY_CELL && i < side; ++i){
+    const int hits = _mm_movemask_epi8(_mm_packs_epi16(
+        _mm_cmpeq_epi16(_mm_load_si128(reinterpret_cast<const __m128i *>(counts[i])), target),
+        _mm_cmpeq_epi16(_mm_load_si128(reinterpret_cast<const __m128i *>(counts[i] + 8)), target)));
+    if(hits){
+      best = i * side + __builtin_ctz(hits);
+      break;
+    }
+  }
+  return result;
+}
+
+
+
+// scan_avx2(in, out, best) is scan_scalar() with each row in one 16-lane vector
+__attribute__((target("avx2")))
+inline int scan_avx2(const board_scan_input &in, const board_scan_output &out, int &best){
+  const int side = in.box_dim * in.box_dim;
+  alignas(32) std::uint16_t cols[16] = {};
+  alignas(32) std::uint16_t bands[6][16];
+  alignas(32) std::uint16_t valid[16];
+  alignas(32) std::uint16_t counts[16][16];
+  for(int j = 0; j < 16; ++j){
+    cols[j] = j < side ? in.col_used[j] : 0;
+    valid[j] = j < side ? 0xffff : 0;
+  }
+  band_boxes(in, bands);
+  const __m256i zero = _mm256_setzero_si256();
+  const __m256i all = _mm256_set1_epi16(static_cast<short>(in.all));
+  const __m256i none = _mm256_set1_epi16(NO_EMPTY_CELL);
+  const __m256i one = _mm256_set1_epi16(1);
+  const __m256i nibbles = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                           0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  const __m256i col_vec = _mm256_load_si256(reinterpret_cast<const __m256i *>(cols));
+  const __m256i lane_ok = _mm256_load_si256(reinterpret_cast<const __m256i *>(valid));
+  __m256i fewest = none;
+  for(int i = 0; i < side; ++i){
+    const __m256i used = _mm256_or_si256(_mm256_set1_epi16(static_cast<short>(in.row_used[i])),
+        _mm256_or_si256(col_vec,
+            _mm256_load_si256(reinterpret_cast<const __m256i *>(bands[i / in.box_dim]))));
+    const __m256i cand = _mm256_andnot_si256(used, all);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(out.cand + 16 * i), cand);
+    // popcount per byte through the nibble table, then add the two bytes of each lane
+    const __m256i bytes = _mm256_add_epi8(_mm256_shuffle_epi8(nibbles, _mm256_and_si256(cand, low)),
+        _mm256_shuffle_epi8(nibbles, _mm256_and_si256(_mm256_srli_epi16(cand, 4), low)));
+    __m256i c = _mm256_add_epi16(_mm256_and_si256(bytes, _mm256_set1_epi16(0xff)),
+                                 _mm256_srli_epi16(bytes, 8));
+    const __m256i cells = _mm256_cvtepu8_epi16(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in.grid + i * side)));
+    const __m256i empty = _mm256_and_si256(_mm256_cmpeq_epi16(cells, zero), lane_ok);
+    c = _mm256_blendv_epi8(none, c, empty);
+    _mm256_store_si256(reinterpret_cast<__m256i *>(counts[i]), c);
+    const __m256i ones = _mm256_permute4x64_epi64(
+        _mm256_packs_epi16(_mm256_cmpeq_epi16(c, one), zero), 0xd8);
+    out.singles[i] = static_cast<std::uint16_t>(_mm256_movemask_epi8(ones));
+    fewest = _mm256_min_epu16(fewest, c);
+  }
+  const __m128i halves = _mm_min_epu16(_mm256_castsi256_si128(fewest),
+                                       _mm256_extracti128_si256(fewest, 1));
+  const int result = _mm_extract_epi16(_mm_minpos_epu16(halves), 0);
+  best = -1;
+  const __m256i target = _mm256_set1_epi16(static_cast<short>(result));
+  for(int i = 0; result != NO_EMPTY_CELL && i < side; ++i){
+    const __m256i hits = _mm256_permute4x64_epi64(_mm256_packs_epi16(_mm256_cmpeq_epi16(
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(counts[i])), target), zero), 0xd8);
+    const int mask = _mm256_movemask_epi8(hits) & 0xffff;
+    if(mask){
+      best = i * side + __builtin_ctz(mask);
+      break;
+    }
+  }
+  return result;
+}
+
+#endif // SIMD_SCAN_X86
+
+
+
+typedef int (*scan_kernel)(const board_scan_input &, const board_scan_output &, int &);
+
+// pick_kernel() returns the fastest kernel the CPU supports
+inline scan_kernel pick_kernel(){
+#ifdef SIMD_SCAN_X86
+  __builtin_cpu_init();
+  if(__builtin_cpu_supports("avx2")){
+    return scan_avx2;
+  }
+  if(__builtin_cpu_supports("sse2")){
+    return scan_sse2;
+  }
+#endif
+  return scan_scalar;
+}
+
+
+
+// board_scan(in, out, best) scans the board with the kernel picked for this CPU, returning
+// the fewest candidates of any empty cell (NO_EMPTY_CELL if there is none) and setting
+// best to the first cell in row-major order that has that many
+
+// requires: in.box_dim must be 3 or 4; out.cand must hold 16 * side masks and out.singles
+//           side words
+
+// time: O(n) vector operations where n is the side of the board
+inline int board_scan(const board_scan_input &in, const board_scan_output &out, int &best){
+  static const scan_kernel kernel = pick_kernel();
+  return kernel(in, out, best);
+}
+
+}
+}
+
+#endif // SIMD_SCAN_H
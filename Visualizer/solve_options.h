@@ -0,0 +1,99 @@
+#ifndef SOLVE_OPTIONS_H
+#define SOLVE_OPTIONS_H
+
+#include <atomic>
+#include <chrono>
+#include "search_stats.h"
+
+// Budgets for a solve, so that a caller with a latency target can give up on a
+// pathological puzzle instead of waiting on it: a limit on search nodes, a deadline and
+// flags other threads can set to cancel. The search looks at the node count at every
+// node, but at the clock and the flags only every check_interval nodes.
+
+namespace sudoku{
+
+// how a budgeted solve ended
+enum solve_result { SOLVE_SOLVED, SOLVE_UNSOLVABLE, SOLVE_EXHAUSTED };
+
+struct solve_options{
+  typedef std::chrono::steady_clock clock;
+  static constexpr long CHECK_INTERVAL = 256;
+
+  // nodes to search at most, or 0 for no limit
+  long max_nodes;
+  // when to give up, or clock::time_point::max() for never
+  clock::time_point deadline;
+  // nodes between two looks at the deadline and at the flags
+  long check_interval;
+  // the search gives up once this is set, if it is not NULL
+  const std::atomic<bool> *cancel;
+  // the same for a second flag, so that code running searches for a caller (like the
+  // race) can stop them itself and still honour the caller's cancel
+  const std::atomic<bool> *stop;
+
+  solve_options() : max_nodes(0), deadline(clock::time_point::max()),
+                    check_interval(CHECK_INTERVAL), cancel(NULL), stop(NULL){}
+
+  // cancelled() returns true if cancel or stop is set
+  bool cancelled() const{
+    return (cancel && cancel->load(std::memory_order_relaxed)) ||
+           (stop && stop->load(std::memory_order_relaxed));
+  }
+
+  // set_timeout(seconds) sets the deadline to seconds from now
+  void set_timeout(double seconds){
+    deadline = clock::now() + std::chrono::duration_cast<clock::duration>(
+        std::chrono::duration<double>(seconds));
+  }
+};
+
+
+
+// budget_counter is a search_counter that also keeps a search within the budget of a
+// solve_options: halt() turns true, and stays true, once the search has run out of
+// nodes or time or has been cancelled
+class budget_counter : public search_counter{
+  public:
+  // requires: stats must not be NULL
+  budget_counter(search_stats *stats, const solve_options &options) :
+      search_counter(stats), options(options), nodes(0), next_check(0),
+      exhausted(false){}
+
+  void node(int depth){
+    search_counter::node(depth);
+    ++nodes;
+  }
+
+  bool halt(){
+    if(exhausted){
+      return true;
+    }
+    if(options.max_nodes && nodes >= options.max_nodes){
+      exhausted = true;
+    } else if(nodes >= next_check){
+      next_check = nodes + options.check_interval;
+      exhausted = options.cancelled() || solve_options::clock::now() >= options.deadline;
+    }
+    return exhausted;
+  }
+
+  // halted() returns true if halt() has stopped the search
+  bool halted() const{
+    return exhausted;
+  }
+
+  // nodes_searched() returns the nodes counted, whether or not SUDOKU_STATS is on
+  long nodes_searched() const{
+    return nodes;
+  }
+
+  private:
+  const solve_options &options;
+  long nodes;
+  long next_check;
+  bool exhausted;
+};
+
+}
+
+#endif // SOLVE_OPTIONS_H
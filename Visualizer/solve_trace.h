@@ -0,0 +1,365 @@
+#ifndef SOLVE_TRACE_H
+#define SOLVE_TRACE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Compact record of every step of a search, so that a solve can be watched (or
+// inspected) later, at any speed and from any point, without solving it again.
+//
+// A trace file starts with a header: the bytes "SDTR", the format version, the block
+// size and then one byte per cell with the board the search started from. After that
+// each step (a number placed at a cell, or a cell cleared, as number 0) is one varint
+// (7 bits a byte, lowest first) holding zigzag(cell - previous cell) * (SIDE + 1) + val,
+// so no step of a board up to 16x16 takes more than two bytes.
+
+namespace sudoku{
+
+class solve_trace{
+  public:
+  static constexpr int VERSION = 1;
+  static constexpr int HEADER = 6;
+
+  // solve_trace(out) starts an empty trace. With out set, the buffer is written to out
+  // whenever it grows past FLUSH_BYTES, so long searches are traced in bounded memory
+  explicit solve_trace(FILE *out = NULL) : out(out), radix(1), prev(0), count(0), failed(false){}
+
+
+
+  // begin(box_dim, cells) drops any steps not flushed yet and starts the trace of a
+  // search of the box_dim board in cells
+
+  // requires: cells must hold box_dim^4 values
+  void begin(int box_dim, const int *cells){
+    const int side = box_dim * box_dim;
+    radix = side + 1;
+    prev = 0;
+    count = 0;
+    buffer.clear();
+    const std::uint8_t header[HEADER] = {'S', 'D', 'T', 'R', VERSION,
+                                         static_cast<std::uint8_t>(box_dim)};
+    buffer.insert(buffer.end(), header, header + HEADER);
+    for(int cell = 0; cell < side * side; ++cell){
+      buffer.push_back(static_cast<std::uint8_t>(cells[cell]));
+    }
+  }
+
+
+
+  // assigned(cell, val) records val placed at cell, cleared(cell) the cell emptied
+
+  // time: O(1) amortised
+  void assigned(int cell, int val){
+    const int delta = cell - prev;
+    std::uint32_t code = (static_cast<std::uint32_t>(delta) << 1 ^ static_cast<std::uint32_t>(delta >> 31)) *
+                         radix + val;
+    while(code >= 0x80){
+      buffer.push_back(static_cast<std::uint8_t>(code | 0x80));
+      code >>= 7;
+    }
+    buffer.push_back(static_cast<std::uint8_t>(code));
+    prev = cell;
+    ++count;
+    if(out && buffer.size() >= FLUSH_BYTES){
+      flush();
+    }
+  }
+
+  void cleared(int cell){
+    assigned(cell, 0);
+  }
+
+
+
+  // flush() writes the buffered bytes to out and empties the buffer, and returns false if
+  // any write to out has failed
+
+  // requires: the trace must have been given an out
+  bool flush(){
+    if(!buffer.empty() && fwrite(buffer.data(), 1, buffer.size(), out) != buffer.size()){
+      failed = true;
+    }
+    buffer.clear();
+    return !failed && fflush(out) == 0;
+  }
+
+
+
+  // save(path) writes the whole trace to the file at path and returns true, or returns
+  // false if it cannot
+
+  // requires: the trace must have been made without an out
+  bool save(const char *path) const{
+    FILE *file = fopen(path, "wb");
+    if(!file){
+      return false;
+    }
+    const bool ok = fwrite(buffer.data(), 1, buffer.size(), file) == buffer.size();
+    return fclose(file) == 0 && ok;
+  }
+
+  // steps() returns the number of steps recorded since begin()
+  long steps() const{
+    return count;
+  }
+
+  // bytes() returns the trace not flushed yet
+  const std::vector<std::uint8_t> &bytes() const{
+    return buffer;
+  }
+
+
+
+  private:
+  static constexpr size_t FLUSH_BYTES = 1 << 20;
+  FILE *out;
+  std::vector<std::uint8_t> buffer;
+  std::uint32_t radix;
+  int prev;
+  long count;
+  bool failed;
+};
+
+
+
+// trace_counter<SOLVER> is a search counter (see search_stats.h) that records the steps
+// of a solver's search in a solve_trace: it reads the cells it is told about off the
+// solver's trail, which still holds them when the counter is called
+template <class SOLVER>
+class trace_counter{
+  public:
+  trace_counter(const SOLVER &board, solve_trace *trace) : board(board), trace(trace){}
+  void node(int){}
+  bool halt(){
+    return false;
+  }
+
+  void placed(long count){
+    for(int k = board.trail_size() - count; k < board.trail_size(); ++k){
+      trace->assigned(board.trail_cell(k), board.read(board.trail_cell(k)));
+    }
+  }
+
+  void guessed(){
+    placed(1);
+  }
+
+  void undone(long count){
+    for(int k = board.trail_size() - 1; k >= board.trail_size() - count; --k){
+      trace->cleared(board.trail_cell(k));
+    }
+  }
+
+  std::uint64_t start() const{
+    return 0;
+  }
+  void selected(std::uint64_t){}
+  void checked(std::uint64_t){}
+
+  private:
+  const SOLVER &board;
+  solve_trace *trace;
+};
+
+
+
+// trace_player plays a trace file back: it steps through the trace one step at a time
+// and jumps to any step by starting from the nearest board snapshot before it, taken
+// every SNAPSHOT_STEPS steps when the file is loaded
+class trace_player{
+  public:
+  static constexpr long SNAPSHOT_STEPS = 4096;
+
+  trace_player() : dim(0), side(0), cells(0), pos(0), prev(0), at(0), total(0){}
+
+
+
+  // load(path) reads the trace file at path and rewinds to its first step, and returns
+  // false (leaving the player empty) if the file cannot be read or is not a trace. A
+  // trace cut short, as by a search that was killed, plays up to its last whole step
+
+  // time: O(n) where n is the size of the file
+  bool load(const char *path){
+    clear();
+    FILE *file = fopen(path, "rb");
+    if(!file){
+      return false;
+    }
+    std::uint8_t block[1 << 16];
+    for(size_t got; (got = fread(block, 1, sizeof(block), file)) > 0; ){
+      data.insert(data.end(), block, block + got);
+    }
+    fclose(file);
+    if(data.size() < solve_trace::HEADER || data[0] != 'S' || data[1] != 'D' || data[2] != 'T' ||
+       data[3] != 'R' || data[4] != solve_trace::VERSION || data[5] < 2 || data[5] > 6){
+      clear();
+      return false;
+    }
+    dim = data[5];
+    side = dim * dim;
+    cells = side * side;
+    if(data.size() < static_cast<size_t>(solve_trace::HEADER + cells)){
+      clear();
+      return false;
+    }
+    start.assign(data.begin() + solve_trace::HEADER, data.begin() + solve_trace::HEADER + cells);
+    for(int cell = 0; cell < cells; ++cell){
+      if(start[cell] > side){
+        clear();
+        return false;
+      }
+    }
+    // one pass to count the steps and take the snapshots
+    rewind();
+    int cell, val;
+    for(;;){
+      if(at % SNAPSHOT_STEPS == 0){
+        snapshot shot = {pos, prev};
+        snapshots.push_back(shot);
+        snapshot_boards.insert(snapshot_boards.end(), board.begin(), board.end());
+      }
+      if(!next(cell, val)){
+        break;
+      }
+    }
+    total = at;
+    rewind();
+    return true;
+  }
+
+
+
+  // next(cell, val) applies the next step to the board, sets cell and val to it and
+  // returns true, or returns false if the trace is over
+
+  // time: O(1)
+  bool next(int &cell, int &val){
+    if(total && at == total){
+      return false;
+    }
+    std::uint32_t code = 0;
+    size_t read = pos;
+    for(int shift = 0; ; shift += 7){
+      if(read == data.size() || shift > 28){
+        return false;
+      }
+      code |= static_cast<std::uint32_t>(data[read] & 0x7f) << shift;
+      if(!(data[read++] & 0x80)){
+        break;
+      }
+    }
+    const std::uint32_t zigzag = code / (side + 1);
+    val = code % (side + 1);
+    cell = prev + static_cast<int>(zigzag >> 1 ^ (0u - (zigzag & 1)));
+    if(cell < 0 || cell >= cells){
+      return false;
+    }
+    board[cell] = val;
+    pos = read;
+    prev = cell;
+    ++at;
+    return true;
+  }
+
+
+
+  // seek(frame) moves to the board after frame steps (or after the last step, if the
+  // trace is shorter)
+
+  // time: O(SNAPSHOT_STEPS + n) where n is the number of cells
+  void seek(long frame){
+    if(frame > total){
+      frame = total;
+    }
+    if(frame < 0){
+      frame = 0;
+    }
+    const long shot = frame / SNAPSHOT_STEPS;
+    if(shot >= static_cast<long>(snapshots.size())){
+      return;
+    }
+    if(frame < at || shot > at / SNAPSHOT_STEPS){
+      pos = snapshots[shot].pos;
+      prev = snapshots[shot].prev;
+      at = shot * SNAPSHOT_STEPS;
+      board.assign(snapshot_boards.begin() + shot * cells, snapshot_boards.begin() + (shot + 1) * cells);
+    }
+    int cell, val;
+    while(at < frame && next(cell, val)){}
+  }
+
+
+
+  // box_dim(), board_side() and board_cells() describe the board of the trace
+  int box_dim() const{
+    return dim;
+  }
+
+  int board_side() const{
+    return side;
+  }
+
+  int board_cells() const{
+    return cells;
+  }
+
+  // frames() returns the number of steps in the trace, frame() the number played so far
+  long frames() const{
+    return total;
+  }
+
+  long frame() const{
+    return at;
+  }
+
+  // read(cell) returns the number at cell after the steps played so far, or 0
+  int read(int cell) const{
+    return board[cell];
+  }
+
+  // given(cell) returns true if cell was filled before the search started
+  bool given(int cell) const{
+    return start[cell] != 0;
+  }
+
+
+
+  private:
+  struct snapshot{
+    size_t pos;
+    int prev;
+  };
+  std::vector<std::uint8_t> data;
+  std::vector<std::uint8_t> start;
+  std::vector<std::uint8_t> board;
+  std::vector<snapshot> snapshots;
+  std::vector<std::uint8_t> snapshot_boards;
+  int dim, side, cells;
+  size_t pos;
+  int prev;
+  long at, total;
+
+  void clear(){
+    data.clear();
+    start.clear();
+    board.clear();
+    snapshots.clear();
+    snapshot_boards.clear();
+    dim = side = cells = 0;
+    pos = 0;
+    prev = 0;
+    at = total = 0;
+  }
+
+  void rewind(){
+    board = start;
+    pos = solve_trace::HEADER + cells;
+    prev = 0;
+    at = 0;
+  }
+};
+
+}
+
+#endif // SOLVE_TRACE_H
@@ -0,0 +1,155 @@
+#ifndef SOLVE_WORKER_H
+#define SOLVE_WORKER_H
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "solver.h"
+#include "step_queue.h"
+
+// Runs a 9x9 solve on its own thread so the window stays responsive. In animated mode
+// every placement and every clearing the search makes is pushed to steps, for the GUI
+// thread to pop and draw at its own pace; when the GUI falls behind and the queue fills
+// up, the search waits for it. In instant mode the search runs at full speed and only
+// the result is kept. Both run solver::search itself, and both stop soon after cancel().
+
+namespace sudoku{
+
+class solve_worker{
+  public:
+  typedef solver<3> solver_type;
+  static constexpr int CELLS = solver_type::CELLS;
+  typedef step_queue<1 << 16> queue_type;
+
+  // the queue of steps to draw; only the GUI thread may pop from it
+  queue_type steps;
+
+  solve_worker() : stop(false), done(false), solved(false){}
+
+  ~solve_worker(){
+    cancel();
+  }
+
+
+
+  // start(cells, animate) cancels any solve still running, drops its queued steps and
+  // starts solving the row-major cells on the worker thread, pushing every step to
+  // steps if animate is true
+
+  // requires: cells must hold CELLS values
+  void start(const int *cells, bool animate){
+    cancel();
+    steps.clear();
+    done.store(false, std::memory_order_relaxed);
+    solved = false;
+    const bool consistent = board.load(cells);
+    thread = std::thread([this, consistent, animate](){
+      if(!consistent){
+        solved = false;
+      } else if(animate){
+        step_counter counter(*this);
+        solved = board.solve_with(counter);
+      } else{
+        solve_options options;
+        options.cancel = &stop;
+        search_stats stats;
+        solved = board.solve(options, &stats) == SOLVE_SOLVED;
+      }
+      done.store(true, std::memory_order_release);
+    });
+  }
+
+
+
+  // cancel() stops the running solve, if any, and waits for the worker thread to end
+  void cancel(){
+    if(thread.joinable()){
+      stop.store(true, std::memory_order_relaxed);
+      thread.join();
+      stop.store(false, std::memory_order_relaxed);
+    }
+  }
+
+
+
+  // finished() returns true once the solve has ended; the steps may still be queued
+  bool finished() const{
+    return done.load(std::memory_order_acquire);
+  }
+
+
+
+  // result(cells) returns true and writes the solution into cells if the solve found
+  // one, and returns false otherwise
+
+  // requires: finished() must be true, cells must hold CELLS values
+  bool result(int *cells) const{
+    if(solved){
+      board.store(cells);
+    }
+    return solved;
+  }
+
+
+
+  private:
+  std::thread thread;
+  std::atomic<bool> stop;
+  std::atomic<bool> done;
+  bool solved;
+  solver_type board;
+
+  // push(cell, val) queues one step, waiting while the queue is full; the step is
+  // dropped if the solve is being cancelled
+  void push(int cell, int val){
+    const step_event step = {static_cast<std::uint16_t>(cell), static_cast<std::uint8_t>(val)};
+    while(!steps.push(step)){
+      if(stop.load(std::memory_order_relaxed)){
+        return;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+
+  // step_counter is a search counter (see search_stats.h) that queues the steps of the
+  // search, reading them off the trail like trace_counter, and halts it on cancel()
+  class step_counter{
+    public:
+    explicit step_counter(solve_worker &worker) : worker(worker){}
+    void node(int){}
+    bool halt(){
+      return worker.stop.load(std::memory_order_relaxed);
+    }
+
+    void placed(long count){
+      const solver_type &board = worker.board;
+      for(int k = board.trail_size() - count; k < board.trail_size(); ++k){
+        worker.push(board.trail_cell(k), board.read(board.trail_cell(k)));
+      }
+    }
+
+    void guessed(){
+      placed(1);
+    }
+
+    void undone(long count){
+      const solver_type &board = worker.board;
+      for(int k = board.trail_size() - 1; k >= board.trail_size() - count; --k){
+        worker.push(board.trail_cell(k), 0);
+      }
+    }
+
+    std::uint64_t start() const{
+      return 0;
+    }
+    void selected(std::uint64_t){}
+    void checked(std::uint64_t){}
+
+    private:
+    solve_worker &worker;
+  };
+};
+
+}
+
+#endif // SOLVE_WORKER_H
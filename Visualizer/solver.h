@@ -0,0 +1,793 @@
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <type_traits>
+#include "search_stats.h"
+#include "simd_scan.h"
+#include "solve_options.h"
+#include "solve_trace.h"
+
+// Header-only backtracking solver shared by the Visualizer (9x9) and the command line
+// programs in backtracking_algorithm (9x9 and 16x16). Everything that depends on the
+// board size (loop bounds, mask width, peer and unit tables) is a compile-time constant
+// of the template, so every size gets its own fully specialised search.
+
+namespace sudoku{
+
+// how the solver picks the next empty cell to branch on: in row-major order, by fewest
+// candidates from incrementally kept buckets, or by fewest candidates from a vectorised
+// rescan of the whole board (see simd_scan.h)
+enum select_mode { SELECT_ROW_MAJOR, SELECT_MRV, SELECT_MRV_SCAN };
+// which cell wins when several share the fewest candidates
+enum tie_break { TIE_FIRST, TIE_ROW_MAJOR, TIE_MAX_DEGREE };
+
+
+
+// mask_type<SIDE>::type is the narrowest unsigned integer with one bit per number
+template <int SIDE>
+struct mask_type{
+  typedef typename std::conditional<(SIDE <= 16), std::uint16_t,
+          typename std::conditional<(SIDE <= 32), std::uint32_t,
+                                    std::uint64_t>::type>::type type;
+};
+
+
+
+// solver_tables<BOX_DIM> holds the row, column and block of every cell, the peers of
+// every cell (the other cells sharing a row, column or block with it) and the cells of
+// every unit (rows first, then columns, then blocks). It is built at compile time.
+template <int BOX_DIM>
+struct solver_tables{
+  static constexpr int SIDE = BOX_DIM * BOX_DIM;
+  static constexpr int CELLS = SIDE * SIDE;
+  static constexpr int PEERS = 3 * SIDE - 2 * BOX_DIM - 1;
+  static constexpr int UNITS = 3 * SIDE;
+
+  std::uint16_t row[CELLS];
+  std::uint16_t col[CELLS];
+  std::uint16_t box[CELLS];
+  std::uint16_t peers[CELLS][PEERS];
+  std::uint16_t units[UNITS][SIDE];
+
+  constexpr solver_tables() : row(), col(), box(), peers(), units(){
+    for(int cell = 0; cell < CELLS; ++cell){
+      const int i = cell / SIDE;
+      const int j = cell % SIDE;
+      const int b = (i / BOX_DIM) * BOX_DIM + j / BOX_DIM;
+      row[cell] = i;
+      col[cell] = j;
+      box[cell] = b;
+      units[i][j] = cell;
+      units[SIDE + j][i] = cell;
+      units[2 * SIDE + b][(i % BOX_DIM) * BOX_DIM + j % BOX_DIM] = cell;
+      int n = 0;
+      for(int k = 0; k < SIDE; ++k){
+        if(k != j){
+          peers[cell][n++] = i * SIDE + k;
+        }
+      }
+      for(int k = 0; k < SIDE; ++k){
+        if(k != i){
+          peers[cell][n++] = k * SIDE + j;
+        }
+      }
+      const int bi = (i / BOX_DIM) * BOX_DIM;
+      const int bj = (j / BOX_DIM) * BOX_DIM;
+      for(int r = bi; r < bi + BOX_DIM; ++r){
+        for(int c = bj; c < bj + BOX_DIM; ++c){
+          if(r != i && c != j){
+            peers[cell][n++] = r * SIDE + c;
+          }
+        }
+      }
+    }
+  }
+};
+
+
+
+template <int BOX_DIM>
+class solver;
+
+// search_hooks<BOX_DIM> lets other threads steer a running solver::search(). Setting stop
+// makes every search using the hooks give up (return false) at its next node, and while
+// want_work() is true a search hands all but the first candidate of the cell it is about
+// to branch on to donate(), together with a copy of its state, instead of trying them
+// itself.
+template <int BOX_DIM>
+class search_hooks{
+  public:
+  typedef typename mask_type<BOX_DIM * BOX_DIM>::type mask_t;
+  std::atomic<bool> stop;
+
+  search_hooks() : stop(false){}
+  virtual ~search_hooks(){}
+  virtual bool want_work() const = 0;
+  virtual void donate(const solver<BOX_DIM> &state, int cell, mask_t cands) = 0;
+};
+
+
+
+// solver<BOX_DIM> solves boards of SIDE x SIDE cells (SIDE = BOX_DIM^2) stored row-major
+// as numbers 1..SIDE, with 0 for an empty cell. It keeps a bitmask of the numbers used
+// in each row, column and block, propagates naked and hidden singles, branches on the
+// cell picked by next_cell() and undoes through a trail of assigned cells.
+//
+// A solver is a plain value: copying one copies the whole search state.
+template <int BOX_DIM>
+class solver{
+  public:
+  typedef solver_tables<BOX_DIM> tables_type;
+  static constexpr int SIDE = tables_type::SIDE;
+  static constexpr int CELLS = tables_type::CELLS;
+  static constexpr int PEERS = tables_type::PEERS;
+  static constexpr int UNITS = tables_type::UNITS;
+  typedef typename mask_type<SIDE>::type mask_t;
+  static constexpr mask_t ALL = static_cast<mask_t>((std::uint64_t(1) << SIDE) - 1);
+  static constexpr int FULL = -1;
+  // row stride of the whole-board scan: one 16-lane vector per row where masks fit
+  static constexpr int SCAN_STRIDE = SIDE <= 16 ? 16 : SIDE;
+  static constexpr tables_type tables{};
+
+  solver(){
+    hooks = NULL;
+    version = 0;
+    scan_version = ~0u;
+    // the vectorised rescan is cheaper per node than keeping the buckets, which move up
+    // to PEERS cells between lists on every assignment; boards too wide for the vectors
+    // keep the buckets
+    set_selection(SIDE <= 16 ? SELECT_MRV_SCAN : SELECT_MRV, TIE_FIRST);
+    int empty[CELLS] = {};
+    load(empty);
+  }
+
+
+
+  // set_selection(mode, tie) chooses how next_cell() picks a cell. The candidate-count
+  // buckets are only kept up to date in SELECT_MRV mode, so call this before load()
+  // (SELECT_MRV_SCAN always breaks ties in row-major order)
+  void set_selection(select_mode mode, tie_break tie){
+    this->mode = mode;
+    this->tie = tie;
+  }
+
+
+
+  // load(cells) replaces the board with the given row-major cells and returns true, or
+  // returns false if a value is out of range or two clues clash
+
+  // requires: cells must hold CELLS values
+
+  // time: O(n^2 * p) where n is SIDE and p is PEERS
+  bool load(const int *cells){
+    assert(cells);
+    for(int k = 0; k < SIDE; ++k){
+      row_used[k] = col_used[k] = box_used[k] = 0;
+    }
+    consistent = true;
+    trail_len = 0;
+    ++version;
+    for(int k = CELLS; k < CELLS + 16; ++k){
+      grid[k] = 0;
+    }
+    for(int cell = 0; cell < CELLS; ++cell){
+      const int val = cells[cell];
+      grid[cell] = 0;
+      if(val < 0 || val > SIDE){
+        consistent = false;
+      } else if(val){
+        const mask_t sig = bit(val);
+        if(used(cell) & sig){
+          consistent = false;
+        }
+        grid[cell] = val;
+        row_used[tables.row[cell]] |= sig;
+        col_used[tables.col[cell]] |= sig;
+        box_used[tables.box[cell]] |= sig;
+      }
+    }
+    if(mode != SELECT_MRV){
+      // the buckets and degrees are only read in SELECT_MRV mode
+      return consistent;
+    }
+    for(int node = CELLS; node <= CELLS + SIDE; ++node){
+      next[node] = prev[node] = node;
+    }
+    for(int cell = 0; cell < CELLS; ++cell){
+      if(tie == TIE_MAX_DEGREE){
+        degree[cell] = 0;
+        for(int k = 0; k < PEERS; ++k){
+          if(!grid[tables.peers[cell][k]]){
+            ++degree[cell];
+          }
+        }
+      }
+      if(!grid[cell]){
+        bucket_insert(cell, popcount(candidates(cell)));
+      }
+    }
+    return consistent;
+  }
+
+
+
+  // store(cells) writes the current board into cells in row-major order
+
+  // requires: cells must hold CELLS values
+  void store(int *cells) const{
+    assert(cells);
+    for(int cell = 0; cell < CELLS; ++cell){
+      cells[cell] = grid[cell];
+    }
+  }
+
+
+
+  // read(cell) returns the number at cell, or 0 if it is empty
+  int read(int cell) const{
+    return grid[cell];
+  }
+
+
+
+  // candidates(cell) returns the mask of numbers (bit n-1 for number n) that can still
+  // be placed at cell
+
+  // time: O(1)
+  mask_t candidates(int cell) const{
+    return ALL & ~used(cell);
+  }
+
+
+
+  // assign(cell, val) places val at the empty cell and records it on the trail
+
+  // time: O(p) where p is PEERS
+  void assign(int cell, int val){
+    place(cell, val);
+    trail[trail_len++] = cell;
+  }
+
+
+
+  // undo(mark) clears every cell assigned since trail_size() returned mark, most recent
+  // first
+
+  // time: O(n * p) where n is the number of cells cleared and p is PEERS
+  void undo(int mark){
+    while(trail_len > mark){
+      unplace(trail[--trail_len]);
+    }
+  }
+
+  int trail_size() const{
+    return trail_len;
+  }
+
+  int trail_cell(int k) const{
+    return trail[k];
+  }
+
+
+
+  // propagate() repeatedly assigns naked singles (cells with one candidate) and hidden
+  // singles (numbers with one possible cell in a unit) until neither applies, and
+  // returns false as soon as the board is shown to be contradictory. Assignments stay
+  // on the trail either way; the caller undoes to its own mark
+
+  // time: O(n^4) where n is SIDE in the worst case, usually a few passes of O(n^2)
+  bool propagate(){
+    bool changed = true;
+    while(changed){
+      const int before = trail_len;
+      if(mode == SELECT_MRV){
+        while(next[CELLS + 1] != CELLS + 1){
+          if(next[CELLS] != CELLS){
+            return false;
+          }
+          const int cell = next[CELLS + 1];
+          assign(cell, lowest(candidates(cell)) + 1);
+        }
+        if(next[CELLS] != CELLS){
+          return false;
+        }
+      } else{
+        int best;
+        const int fewest = scan(best);
+        if(fewest == 0){
+          return false;
+        }
+        for(int i = 0; fewest == 1 && i < SIDE; ++i){
+          for(std::uint64_t singles = scan_single[i]; singles; singles &= singles - 1){
+            const int j = __builtin_ctzll(singles);
+            const mask_t sig = scan_cand[i * SCAN_STRIDE + j];
+            // an earlier single in this pass may have taken the only candidate
+            if(!(candidates(i * SIDE + j) & sig)){
+              return false;
+            }
+            assign(i * SIDE + j, lowest(sig) + 1);
+          }
+        }
+      }
+      for(int u = 0; u < UNITS; ++u){
+        if(!hidden_singles(tables.units[u])){
+          return false;
+        }
+      }
+      changed = trail_len != before;
+    }
+    return true;
+  }
+
+
+
+  // next_cell(start) returns the empty cell to branch on next, or FULL if there is none.
+  // In SELECT_ROW_MAJOR mode this is the first empty cell from start on; in the MRV
+  // modes it is a cell with the fewest candidates, so a cell with no candidates left is
+  // returned straight away and the branch fails at once
+
+  // requires: in SELECT_ROW_MAJOR mode every cell before start must be filled
+
+  // time: O(1) for TIE_FIRST, O(n) in the size of the winning bucket otherwise
+  int next_cell(int start) const{
+    if(mode == SELECT_ROW_MAJOR){
+      for(int cell = start; cell < CELLS; ++cell){
+        if(!grid[cell]){
+          return cell;
+        }
+      }
+      return FULL;
+    }
+    if(mode == SELECT_MRV_SCAN){
+      if(scan_version != version){
+        scan(scan_best);
+      }
+      return scan_best < 0 ? FULL : scan_best;
+    }
+    for(int n = 0; n <= SIDE; ++n){
+      const int head = CELLS + n;
+      if(next[head] == head){
+        continue;
+      }
+      int best = next[head];
+      if(tie != TIE_FIRST){
+        for(int cell = next[best]; cell != head; cell = next[cell]){
+          if(tie == TIE_ROW_MAJOR ? cell < best : degree[cell] > degree[best]){
+            best = cell;
+          }
+        }
+      }
+      return best;
+    }
+    return FULL;
+  }
+
+
+
+  // set_hooks(hooks) attaches hooks (or detaches them, if NULL) to later searches; copies
+  // of the solver share them
+  void set_hooks(search_hooks<BOX_DIM> *hooks){
+    this->hooks = hooks;
+  }
+
+
+
+  // search(start) solves the board from the current state, propagating first and then
+  // branching on next_cell(start). Returns true with the board solved, or false with
+  // the board as it was before the call
+
+  // time: O()
+  bool search(int start){
+    no_counter counter(NULL);
+    return search_from(start, 0, counter);
+  }
+
+
+
+  // branch(cell, cands) tries each number in cands at the empty cell in turn and
+  // searches on from there. Returns true with the board solved, or false with the board
+  // as it was before the call
+
+  // requires: cands must be a subset of candidates(cell)
+  bool branch(int cell, mask_t cands){
+    no_counter counter(NULL);
+    return branch_from(cell, cands, 0, counter);
+  }
+
+
+
+  // branch(cell, cands, options, stats) is branch(cell, cands) within the budget of
+  // options, returning like solve(options, stats)
+
+  // requires: cands must be a subset of candidates(cell), stats must not be NULL
+  solve_result branch(int cell, mask_t cands, const solve_options &options, search_stats *stats){
+    stats->clear();
+    budget_counter counter(stats, options);
+    const bool solved = branch_from(cell, cands, 0, counter);
+    stats->nodes = counter.nodes_searched();
+    return solved ? SOLVE_SOLVED : counter.halted() ? SOLVE_EXHAUSTED : SOLVE_UNSOLVABLE;
+  }
+
+
+
+  // solve() returns true and solves the loaded board if it can be solved and returns
+  // false otherwise
+
+  // time: O()
+  bool solve(){
+    return consistent && search(0);
+  }
+
+
+
+  // solve(stats) is solve() that also clears stats and fills it in (see search_stats.h).
+  // Propagation counts as checking, next_cell() as selection
+
+  // requires: stats must not be NULL
+  bool solve(search_stats *stats){
+    stats->clear();
+    search_counter counter(stats);
+    return consistent && search_from(0, 0, counter);
+  }
+
+
+
+  // solve(options, stats) is solve(stats) within the budget of options. It returns
+  // SOLVE_SOLVED with the board solved, SOLVE_UNSOLVABLE, or SOLVE_EXHAUSTED with the
+  // board as loaded if the budget ran out first; stats then counts the search so far,
+  // and stats->nodes is filled in even when SUDOKU_STATS is 0
+
+  // requires: stats must not be NULL
+  solve_result solve(const solve_options &options, search_stats *stats){
+    stats->clear();
+    if(!consistent){
+      return SOLVE_UNSOLVABLE;
+    }
+    budget_counter counter(stats, options);
+    const bool solved = search_from(0, 0, counter);
+    stats->nodes = counter.nodes_searched();
+    return solved ? SOLVE_SOLVED : counter.halted() ? SOLVE_EXHAUSTED : SOLVE_UNSOLVABLE;
+  }
+
+
+
+  // solve_with(counter) is solve() that reports the search to counter, a search counter
+  // like those of search_stats.h and solve_trace.h, and gives up once counter.halt()
+  // returns true
+  template <class COUNTER>
+  bool solve_with(COUNTER &counter){
+    return consistent && search_from(0, 0, counter);
+  }
+
+
+
+  // solve(trace) is solve() that also records every number it places and every cell it
+  // clears in trace, after starting it with the loaded board (see solve_trace.h)
+
+  // requires: trace must not be NULL
+  bool solve(solve_trace *trace){
+    int cells[CELLS];
+    store(cells);
+    trace->begin(BOX_DIM, cells);
+    trace_counter<solver> counter(*this, trace);
+    return consistent && search_from(0, 0, counter);
+  }
+
+
+
+  // count_solutions(limit) returns the number of solutions of the loaded board, counting
+  // no further than limit, and leaves the board as it was. count_solutions(2) == 1 is the
+  // uniqueness check: it stops as soon as a second solution turns up
+
+  // requires: limit >= 1
+
+  // time: O()
+  int count_solutions(int limit){
+    assert(limit >= 1);
+    no_counter counter(NULL);
+    return consistent ? count_from(0, 0, limit, counter) : 0;
+  }
+
+
+
+  // count_solutions(limit, options, stats, found) is count_solutions(limit) within the
+  // budget of options. It sets found to the solutions counted and returns SOLVE_SOLVED
+  // if there are any, SOLVE_UNSOLVABLE if there are none, or SOLVE_EXHAUSTED if the
+  // budget ran out first, found then counting the solutions seen so far
+
+  // requires: limit >= 1, stats must not be NULL
+  solve_result count_solutions(int limit, const solve_options &options, search_stats *stats,
+                               int &found){
+    assert(limit >= 1);
+    stats->clear();
+    found = 0;
+    if(!consistent){
+      return SOLVE_UNSOLVABLE;
+    }
+    budget_counter counter(stats, options);
+    found = count_from(0, 0, limit, counter);
+    stats->nodes = counter.nodes_searched();
+    return counter.halted() ? SOLVE_EXHAUSTED : found ? SOLVE_SOLVED : SOLVE_UNSOLVABLE;
+  }
+
+
+
+  // scan(best) recomputes the candidates of every cell in one pass, vectorised where the
+  // masks fit in 16 bits. It returns the fewest candidates of any empty cell and sets best
+  // to the first such cell (-1 and simd::NO_EMPTY_CELL if the board is full), and leaves
+  // the candidates in scan_cand and the naked singles of each row in scan_single
+
+  // time: O(n) vector operations where n is SIDE, O(n^2) without vectors
+  int scan(int &best) const{
+    const int fewest = scan_board(best, std::integral_constant<bool, (SIDE <= 16)>());
+    scan_version = version;
+    scan_best = best;
+    return fewest;
+  }
+
+
+
+  // lowest(mask) returns the index of the lowest set bit of a non-empty mask
+  static int lowest(mask_t mask){
+    return __builtin_ctzll(mask);
+  }
+
+  // popcount(mask) returns the number of set bits in mask
+  static int popcount(mask_t mask){
+    return __builtin_popcountll(mask);
+  }
+
+  // bit(val) returns the mask bit for the number val
+  static mask_t bit(int val){
+    return static_cast<mask_t>(mask_t(1) << (val - 1));
+  }
+
+
+
+  private:
+  // padded so the scan can read a 16-byte vector from the start of any row
+  std::uint8_t grid[CELLS + 16];
+  mask_t row_used[SIDE];
+  mask_t col_used[SIDE];
+  mask_t box_used[SIDE];
+  bool consistent;
+  select_mode mode;
+  tie_break tie;
+  // candidate-count buckets as circular doubly linked lists: nodes 0..CELLS-1 are the
+  // cells and node CELLS + n is the head of the list of cells with n candidates
+  std::uint16_t next[CELLS + SIDE + 1];
+  std::uint16_t prev[CELLS + SIDE + 1];
+  std::uint8_t count[CELLS];
+  std::uint8_t degree[CELLS];
+  std::uint16_t trail[CELLS];
+  int trail_len;
+  search_hooks<BOX_DIM> *hooks;
+  // bumped on every change to the board, so scan results know when they are stale
+  std::uint32_t version;
+  mutable std::uint32_t scan_version;
+  mutable int scan_best;
+  mutable mask_t scan_cand[SIDE * SCAN_STRIDE];
+  mutable std::uint64_t scan_single[SIDE];
+
+  mask_t used(int cell) const{
+    return row_used[tables.row[cell]] | col_used[tables.col[cell]] | box_used[tables.box[cell]];
+  }
+
+  int scan_board(int &best, std::true_type) const{
+    simd::board_scan_input in = {row_used, col_used, box_used, grid, BOX_DIM, ALL};
+    simd::board_scan_output out = {scan_cand, scan_single};
+    return simd::board_scan(in, out, best);
+  }
+
+  int scan_board(int &best, std::false_type) const{
+    int fewest = simd::NO_EMPTY_CELL;
+    best = -1;
+    for(int i = 0; i < SIDE; ++i){
+      scan_single[i] = 0;
+      for(int j = 0; j < SIDE; ++j){
+        const int cell = i * SIDE + j;
+        const mask_t cand = candidates(cell);
+        scan_cand[i * SCAN_STRIDE + j] = cand;
+        if(grid[cell]){
+          continue;
+        }
+        const int count = popcount(cand);
+        if(count == 1){
+          scan_single[i] |= std::uint64_t(1) << j;
+        }
+        if(count < fewest){
+          fewest = count;
+          best = cell;
+        }
+      }
+    }
+    return fewest;
+  }
+
+  void bucket_insert(int cell, int n){
+    const int head = CELLS + n;
+    count[cell] = n;
+    next[cell] = next[head];
+    prev[cell] = head;
+    prev[next[head]] = cell;
+    next[head] = cell;
+  }
+
+  void bucket_remove(int cell){
+    next[prev[cell]] = next[cell];
+    prev[next[cell]] = prev[cell];
+  }
+
+  // place(cell, val) fills the empty cell, marks val as used in its row, column and
+  // block and moves the peers that lose val as a candidate down one bucket
+  void place(int cell, int val){
+    assert(!grid[cell]);
+    const mask_t sig = bit(val);
+    if(mode == SELECT_MRV){
+      bucket_remove(cell);
+      for(int k = 0; k < PEERS; ++k){
+        const int p = tables.peers[cell][k];
+        if(tie == TIE_MAX_DEGREE){
+          --degree[p];
+        }
+        if(!grid[p] && (candidates(p) & sig)){
+          bucket_remove(p);
+          bucket_insert(p, count[p] - 1);
+        }
+      }
+    }
+    grid[cell] = val;
+    ++version;
+    row_used[tables.row[cell]] |= sig;
+    col_used[tables.col[cell]] |= sig;
+    box_used[tables.box[cell]] |= sig;
+  }
+
+  // unplace(cell) is the inverse of place()
+  void unplace(int cell){
+    assert(grid[cell]);
+    const mask_t sig = bit(grid[cell]);
+    grid[cell] = 0;
+    ++version;
+    row_used[tables.row[cell]] ^= sig;
+    col_used[tables.col[cell]] ^= sig;
+    box_used[tables.box[cell]] ^= sig;
+    if(mode == SELECT_MRV){
+      for(int k = 0; k < PEERS; ++k){
+        const int p = tables.peers[cell][k];
+        if(tie == TIE_MAX_DEGREE){
+          ++degree[p];
+        }
+        if(!grid[p] && (candidates(p) & sig)){
+          bucket_remove(p);
+          bucket_insert(p, count[p] + 1);
+        }
+      }
+      bucket_insert(cell, popcount(candidates(cell)));
+    }
+  }
+
+  // search_from(start, depth, counter) is search(start) at depth levels below the root,
+  // reporting to counter
+  template <class COUNTER>
+  bool search_from(int start, int depth, COUNTER &counter){
+    if((hooks && hooks->stop.load(std::memory_order_relaxed)) || counter.halt()){
+      return false;
+    }
+    counter.node(depth);
+    const int mark = trail_len;
+    std::uint64_t since = counter.start();
+    const bool consistent_so_far = propagate();
+    counter.checked(since);
+    counter.placed(trail_len - mark);
+    if(!consistent_so_far){
+      counter.undone(trail_len - mark);
+      undo(mark);
+      return false;
+    }
+    since = counter.start();
+    const int cell = next_cell(start);
+    counter.selected(since);
+    if(cell == FULL){
+      return true;
+    }
+    mask_t cands = candidates(cell);
+    if(hooks && (cands & (cands - 1)) && hooks->want_work()){
+      const mask_t first = cands & (~cands + 1);
+      hooks->donate(*this, cell, cands & ~first);
+      cands = first;
+    }
+    if(branch_from(cell, cands, depth, counter)){
+      return true;
+    }
+    counter.undone(trail_len - mark);
+    undo(mark);
+    return false;
+  }
+
+  // branch_from(cell, cands, depth, counter) is branch(cell, cands) at depth levels below
+  // the root, reporting to counter
+  template <class COUNTER>
+  bool branch_from(int cell, mask_t cands, int depth, COUNTER &counter){
+    for(; cands; cands &= cands - 1){
+      const int guess = trail_len;
+      assign(cell, lowest(cands) + 1);
+      counter.guessed();
+      if(search_from(cell, depth + 1, counter)){
+        return true;
+      }
+      counter.undone(trail_len - guess);
+      undo(guess);
+    }
+    return false;
+  }
+
+  // count_from(start, depth, limit, counter) counts the solutions reachable from the
+  // current state like search_from(start, depth, counter) looks for one, stopping once
+  // limit have been found or counter halts, and undoes everything it assigned
+  template <class COUNTER>
+  int count_from(int start, int depth, int limit, COUNTER &counter){
+    if(counter.halt()){
+      return 0;
+    }
+    counter.node(depth);
+    const int mark = trail_len;
+    int found = 0;
+    if(propagate()){
+      const int cell = next_cell(start);
+      if(cell == FULL){
+        found = 1;
+      }
+      for(mask_t cands = cell == FULL ? 0 : candidates(cell); cands && found < limit; cands &= cands - 1){
+        const int guess = trail_len;
+        assign(cell, lowest(cands) + 1);
+        found += count_from(cell, depth + 1, limit - found, counter);
+        undo(guess);
+      }
+    }
+    undo(mark);
+    return found;
+  }
+
+  // hidden_singles(unit) assigns every number that has exactly one possible cell left in
+  // the unit, and returns false if some number missing from the unit has no possible
+  // cell at all
+  bool hidden_singles(const std::uint16_t *unit){
+    mask_t once = 0, twice = 0, placed = 0;
+    for(int k = 0; k < SIDE; ++k){
+      const int cell = unit[k];
+      if(grid[cell]){
+        placed |= bit(grid[cell]);
+        continue;
+      }
+      const mask_t cand = candidates(cell);
+      twice |= once & cand;
+      once |= cand;
+    }
+    if((once | placed) != ALL){
+      return false;
+    }
+    for(mask_t singles = once & ~twice & ~placed; singles; singles &= singles - 1){
+      const mask_t sig = singles & (~singles + 1);
+      int k = 0;
+      while(k < SIDE && (grid[unit[k]] || !(candidates(unit[k]) & sig))){
+        ++k;
+      }
+      if(k == SIDE){
+        return false;
+      }
+      assign(unit[k], lowest(sig) + 1);
+    }
+    return true;
+  }
+};
+
+template <int BOX_DIM>
+constexpr solver_tables<BOX_DIM> solver<BOX_DIM>::tables;
+
+}
+
+#endif // SOLVER_H
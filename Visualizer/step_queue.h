@@ -0,0 +1,65 @@
+#ifndef STEP_QUEUE_H
+#define STEP_QUEUE_H
+
+#include <atomic>
+#include <cstdint>
+
+// Lock-free queue of solver steps from one producer thread to one consumer thread. It is a
+// ring of CAPACITY slots: the producer only writes tail and the consumer only writes
+// head, so neither ever waits for a lock; a full queue simply refuses the step.
+
+namespace sudoku{
+
+// one change to the board: val was placed at cell, or cell was cleared if val is 0
+struct step_event{
+  std::uint16_t cell;
+  std::uint8_t val;
+};
+
+template <int CAPACITY>
+class step_queue{
+  static_assert((CAPACITY & (CAPACITY - 1)) == 0, "CAPACITY must be a power of two");
+
+  public:
+  step_queue() : head(0), tail(0){}
+
+  // push(step) appends step and returns true, or returns false if the queue is full.
+  // Only the producer thread may call it
+  bool push(step_event step){
+    const unsigned at = tail.load(std::memory_order_relaxed);
+    if(at - head.load(std::memory_order_acquire) == CAPACITY){
+      return false;
+    }
+    ring[at & (CAPACITY - 1)] = step;
+    tail.store(at + 1, std::memory_order_release);
+    return true;
+  }
+
+  // pop(step) takes the oldest step into step and returns true, or returns false if the
+  // queue is empty. Only the consumer thread may call it
+  bool pop(step_event &step){
+    const unsigned at = head.load(std::memory_order_relaxed);
+    if(at == tail.load(std::memory_order_acquire)){
+      return false;
+    }
+    step = ring[at & (CAPACITY - 1)];
+    head.store(at + 1, std::memory_order_release);
+    return true;
+  }
+
+  // clear() drops every queued step. Only the consumer thread may call it, and only
+  // while the producer is not pushing
+  void clear(){
+    head.store(tail.load(std::memory_order_acquire), std::memory_order_release);
+  }
+
+  private:
+  step_event ring[CAPACITY];
+  // kept on separate cache lines so the two threads do not share one
+  alignas(64) std::atomic<unsigned> head;
+  alignas(64) std::atomic<unsigned> tail;
+};
+
+}
+
+#endif // STEP_QUEUE_H
@@ -0,0 +1,193 @@
+#ifndef STEP_SOLVER_H
+#define STEP_SOLVER_H
+
+#include <atomic>
+#include "solver.h"
+
+// Iterative form of solver::search(): the branching cells live on a preallocated stack
+// of frames instead of the call stack, so the search can run a few nodes at a time,
+// stop between any two nodes and carry on later, and never runs out of stack however
+// many cells are empty. A GUI can step it from a timer, a service can give each call a
+// slice of nodes, and copying a step_solver checkpoints the search.
+
+namespace sudoku{
+
+// where a step_solver's search stands
+enum step_status { STEP_RUNNING, STEP_PAUSED, STEP_SOLVED, STEP_UNSOLVABLE };
+
+template <int BOX_DIM>
+class step_solver{
+  public:
+  typedef solver<BOX_DIM> solver_type;
+  typedef typename solver_type::mask_t mask_t;
+  static constexpr int CELLS = solver_type::CELLS;
+
+  step_solver() : paused(false){
+    int empty[CELLS] = {};
+    load(empty);
+  }
+
+  step_solver(const step_solver &other) : paused(other.paused.load()){
+    copy(other);
+  }
+
+  step_solver &operator=(const step_solver &other){
+    paused.store(other.paused.load());
+    copy(other);
+    return *this;
+  }
+
+
+
+  // set_selection(mode, tie) chooses how the search picks the cell to branch on (see
+  // solver::set_selection); call it before load()
+  void set_selection(select_mode mode, tie_break tie){
+    board.set_selection(mode, tie);
+  }
+
+
+
+  // load(cells) starts a new search of the row-major board in cells and returns true, or
+  // returns false (and the search is over, unsolvable) if the clues clash
+
+  // requires: cells must hold CELLS values
+  bool load(const int *cells){
+    const bool consistent = board.load(cells);
+    state = consistent ? STEP_RUNNING : STEP_UNSOLVABLE;
+    depth = 0;
+    start = 0;
+    node_count = guess_count = 0;
+    return consistent;
+  }
+
+
+
+  // step(n) runs the search for up to n more nodes (a node being one guess and the
+  // propagation that follows it) and returns where it stands. It returns STEP_PAUSED
+  // without doing anything while the search is paused
+
+  // time: O(n) nodes
+  step_status step(long n){
+    for(; n > 0 && state == STEP_RUNNING; --n){
+      if(paused.load(std::memory_order_relaxed)){
+        return STEP_PAUSED;
+      }
+      ++node_count;
+      const int mark = board.trail_size();
+      if(board.propagate()){
+        const int cell = board.next_cell(start);
+        if(cell == solver_type::FULL){
+          state = STEP_SOLVED;
+          break;
+        }
+        frame &pushed = stack[depth++];
+        pushed.cell = cell;
+        pushed.untried = board.candidates(cell);
+        pushed.mark = mark;
+        pushed.guess = board.trail_size();
+      } else{
+        board.undo(mark);
+      }
+      // the next guess is the next untried number of the deepest cell that has one
+      while(depth > 0 && !stack[depth - 1].untried){
+        board.undo(stack[depth - 1].mark);
+        --depth;
+      }
+      if(depth == 0){
+        state = STEP_UNSOLVABLE;
+        break;
+      }
+      frame &top = stack[depth - 1];
+      board.undo(top.guess);
+      board.assign(top.cell, solver_type::lowest(top.untried) + 1);
+      top.untried &= top.untried - 1;
+      start = top.cell;
+      ++guess_count;
+    }
+    return paused.load(std::memory_order_relaxed) && state == STEP_RUNNING ? STEP_PAUSED : state;
+  }
+
+
+
+  // run() runs the search until it is solved, shown unsolvable or paused
+  step_status run(){
+    step_status now;
+    while((now = step(1 << 16)) == STEP_RUNNING){}
+    return now;
+  }
+
+
+
+  // pause() makes step() and run() stop before their next node, resume() lets them go
+  // on. Both may be called from any thread
+  void pause(){
+    paused.store(true, std::memory_order_relaxed);
+  }
+
+  void resume(){
+    paused.store(false, std::memory_order_relaxed);
+  }
+
+
+
+  // status() returns where the search stands without running it
+  step_status status() const{
+    return paused.load(std::memory_order_relaxed) && state == STEP_RUNNING ? STEP_PAUSED : state;
+  }
+
+  // board_state() returns the board as the search has left it: solved once status() is
+  // STEP_SOLVED, part way through while it is running
+  const solver_type &board_state() const{
+    return board;
+  }
+
+  // nodes() and guesses() count the nodes run and the numbers guessed since load()
+  long nodes() const{
+    return node_count;
+  }
+
+  long guesses() const{
+    return guess_count;
+  }
+
+  // search_depth() returns the number of cells being branched on
+  int search_depth() const{
+    return depth;
+  }
+
+
+
+  private:
+  // a cell being branched on: the numbers not tried at it yet, the trail size before
+  // the propagation that led to it and the trail size before its current guess
+  struct frame{
+    int cell;
+    mask_t untried;
+    int mark;
+    int guess;
+  };
+
+  solver_type board;
+  frame stack[CELLS];
+  int depth;
+  int start;
+  step_status state;
+  long node_count, guess_count;
+  std::atomic<bool> paused;
+
+  void copy(const step_solver &other){
+    board = other.board;
+    for(int k = 0; k < other.depth; ++k){
+      stack[k] = other.stack[k];
+    }
+    depth = other.depth;
+    start = other.start;
+    state = other.state;
+    node_count = other.node_count;
+    guess_count = other.guess_count;
+  }
+};
+
+}
+
+#endif // STEP_SOLVER_H
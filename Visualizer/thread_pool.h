@@ -0,0 +1,192 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// A fixed pool of worker threads that runs batches of numbered tasks. Each worker owns a
+// deque of task indexes: it takes work from the back of its own deque and, once that is
+// empty, steals from the front of the other workers' deques. Tasks whose cost varies by
+// orders of magnitude (like puzzles of mixed difficulty) therefore keep every worker busy
+// until the whole batch is done. A caller that finds its tasks while earlier ones run
+// (like a reader going through its input) can instead post them one at a time with
+// begin(), post() and wait(), without waiting for a batch to finish before the next.
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class work_stealing_pool{
+  public:
+  // work_stealing_pool(threads) starts threads workers (at least one)
+  explicit work_stealing_pool(int threads) : queues(threads < 1 ? 1 : threads){
+    job = NULL;
+    remaining = 0;
+    generation = 0;
+    active = 0;
+    next_queue = 0;
+    stopping = false;
+    for(size_t id = 0; id < queues.size(); ++id){
+      workers.push_back(std::thread(&work_stealing_pool::worker_loop, this, static_cast<int>(id)));
+    }
+  }
+
+  ~work_stealing_pool(){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    wake.notify_all();
+    for(size_t id = 0; id < workers.size(); ++id){
+      workers[id].join();
+    }
+  }
+
+  // size() returns the number of workers
+  int size() const{
+    return static_cast<int>(queues.size());
+  }
+
+
+
+  // run(tasks, job) calls job(task, worker) once for every task in [0, tasks) on the
+  // pool's workers and returns when all of them have finished. worker is the index of
+  // the calling worker in [0, size()), so job can keep per-worker state without locking.
+  // Tasks are dealt out to the workers in contiguous runs
+
+  // requires: job must not call run() on the same pool
+  void run(int tasks, const std::function<void(int, int)> &job){
+    if(tasks <= 0){
+      return;
+    }
+    const int n = size();
+    std::unique_lock<std::mutex> lock(mutex);
+    this->job = &job;
+    remaining = tasks;
+    for(int id = 0; id < n; ++id){
+      std::lock_guard<std::mutex> queue_lock(queues[id].mutex);
+      for(int task = tasks * id / n; task < tasks * (id + 1) / n; ++task){
+        queues[id].tasks.push_back(task);
+      }
+    }
+    ++generation;
+    wake.notify_all();
+    done.wait(lock, [this]{ return remaining == 0 && active == 0; });
+    this->job = NULL;
+  }
+
+
+
+  // begin(job) starts a batch whose tasks are posted one at a time with post(), each
+  // run as job(task, worker) like the tasks of run(). wait() ends the batch
+
+  // requires: no batch may be running, job must outlive the batch
+  void begin(const std::function<void(int, int)> &job){
+    std::lock_guard<std::mutex> lock(mutex);
+    this->job = &job;
+    remaining = 0;
+  }
+
+  // post(task) queues task in the batch started by begin() and wakes an idle worker for
+  // it. Tasks are dealt out to the workers' deques in turn
+
+  // requires: must be called between begin() and wait(), from one thread at a time
+  void post(int task){
+    ++remaining;
+    task_queue &queue = queues[next_queue];
+    next_queue = (next_queue + 1) % size();
+    {
+      std::lock_guard<std::mutex> queue_lock(queue.mutex);
+      queue.tasks.push_back(task);
+    }
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      ++generation;
+    }
+    wake.notify_one();
+  }
+
+  // wait() returns once every task posted since begin() has finished, and ends the batch
+  void wait(){
+    std::unique_lock<std::mutex> lock(mutex);
+    done.wait(lock, [this]{ return remaining == 0 && active == 0; });
+    job = NULL;
+  }
+
+
+
+  private:
+  struct task_queue{
+    std::mutex mutex;
+    std::deque<int> tasks;
+  };
+
+  std::vector<task_queue> queues;
+  std::vector<std::thread> workers;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::condition_variable done;
+  const std::function<void(int, int)> *job;
+  std::atomic<int> remaining;
+  unsigned generation;
+  int active;
+  // the deque post() puts its next task on
+  int next_queue;
+  bool stopping;
+
+  // take(id, task) pops the next task for worker id, from its own deque if possible and
+  // stolen from another worker otherwise, and returns false if every deque is empty
+  bool take(int id, int &task){
+    const int n = size();
+    for(int k = 0; k < n; ++k){
+      task_queue &queue = queues[(id + k) % n];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if(queue.tasks.empty()){
+        continue;
+      }
+      if(k == 0){
+        task = queue.tasks.back();
+        queue.tasks.pop_back();
+      } else{
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+      }
+      return true;
+    }
+    return false;
+  }
+
+  void worker_loop(int id){
+    unsigned seen = 0;
+    for(;;){
+      const std::function<void(int, int)> *current;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        wake.wait(lock, [&]{ return stopping || generation != seen; });
+        if(stopping){
+          return;
+        }
+        seen = generation;
+        if(!job){
+          // woke up after the batch it was signalled for had already finished
+          continue;
+        }
+        current = job;
+        ++active;
+      }
+      int task;
+      while(take(id, task)){
+        (*current)(task, id);
+        --remaining;
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        --active;
+      }
+      done.notify_all();
+    }
+  }
+};
+
+#endif // THREAD_POOL_H
@@ -0,0 +1,412 @@
+//# Backtracking-Sudoku-Solver
+//Sudoku solver using a backtracking algorithm
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <thread>
+#include "../Visualizer/solver.h"
+#include "batch.h"
+#include "dedupe.h"
+#include "generate.h"
+#define DIM 16
+#define BOX_DIM 4
+
+
+
+// print_line() prints out the top and bottom lines for the grid
+
+// effects: produces output
+
+// time: O(n) 
+void print_line(void){
+  const int num_iterations = (3 * DIM) + DIM + 1;
+  for(int i = 0; i < num_iterations; ++i){
+    printf("-");
+  }
+  printf("\n");
+}
+
+
+
+// print_grid(grid) prints out the current state of the given grid
+
+// effects: produces output
+
+// requires: grid must not be NULL
+
+// time: O(n^3) where n is DIM
+void print_grid(int grid[DIM][DIM]){
+  print_line();
+  
+  for(int row = 0; row < DIM; ++row){
+    printf("|");
+    for(int col = 0; col < DIM; ++col){
+      if(grid[row][col] == 0){
+        printf("   |");
+      } else{
+        printf(" %d |", grid[row][col]);
+      }
+    }
+    printf("\n");
+    print_line();
+  }
+}
+
+
+
+// sudoku_solver(grid) returns true and solves the given grid if it can be solved and returns
+// false otherwise
+
+// effects: may mutate grid
+
+// requires: grid must not be NULL
+
+// time: O()
+bool sudoku_solver(int grid[DIM][DIM]){
+  assert(grid);
+  sudoku::solver<BOX_DIM> board;
+  if(!board.load(&grid[0][0]) || !board.solve()){
+    return false;
+  }
+  board.store(&grid[0][0]);
+  return true;
+}
+
+
+
+// run_batch(path, threads, split, limits, binary_dim) solves every puzzle line of the
+// file at path, or of stdin if path is NULL, writes the solutions to stdout in input
+// order and reports the throughput on stderr. The threads either take whole puzzles
+// each, giving up on those that run over limits, or, if split is true, all work on one
+// puzzle at a time. If binary_dim is not 0 the solutions are written as a result stream
+// of boards with that block size. A file that can be mapped is parsed in place. Returns
+// the process exit status
+
+// effects: reads input, produces output
+int run_batch(const char *path, int threads, bool split, const batch_limits &limits,
+              int binary_dim){
+  batch_stats stats;
+  mapped_file map;
+  if(path && map.open(path)){
+    solve_batch_mapped(map.data(), map.size(), stdout, threads, split, limits, binary_dim,
+                       &stats);
+    print_batch_stats(&stats);
+    return 0;
+  }
+  FILE *in = path ? fopen(path, "rb") : stdin;
+  if(!in){
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+  if(split || threads == 1){
+    solve_batch(in, stdout, threads, limits, binary_dim, &stats);
+  } else{
+    solve_batch_parallel(in, stdout, threads, limits, binary_dim, &stats);
+  }
+  if(path){
+    fclose(in);
+  }
+  print_batch_stats(&stats);
+  return 0;
+}
+
+
+
+// run_decode(path) writes the records of the result stream at path to stdout (see
+// decode_results()). Returns the process exit status
+
+// effects: reads input, produces output
+int run_decode(const char *path){
+  result_reader reader;
+  if(!reader.open(path)){
+    fprintf(stderr, "%s is not a result stream\n", path);
+    return 1;
+  }
+  decode_results(reader, stdout);
+  return 0;
+}
+
+
+
+// run_dedupe(path, threads) writes the lines of the file at path, or of stdin if path is
+// NULL, to stdout without the 9x9 puzzles equivalent to earlier ones, and reports how
+// many distinct puzzles there were on stderr. Returns the process exit status
+
+// effects: reads input, produces output
+int run_dedupe(const char *path, int threads){
+  FILE *in = path ? fopen(path, "rb") : stdin;
+  if(!in){
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+  dedupe_stats stats;
+  dedupe_batch(in, stdout, threads, &stats);
+  if(path){
+    fclose(in);
+  }
+  print_dedupe_stats(&stats);
+  return 0;
+}
+
+
+
+// run_generate(path, count, options, threads) writes count puzzles to the file at path,
+// or to stdout if path is NULL, and reports the throughput on stderr. Returns the process
+// exit status
+
+// effects: produces output
+int run_generate(const char *path, long count, const generate_options &options, int threads){
+  FILE *out = path ? fopen(path, "wb") : stdout;
+  if(!out){
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+  generate_stats stats;
+  if(options.box_dim == 4){
+    generate_puzzles<4>(out, count, options, threads, &stats);
+  } else{
+    generate_puzzles<3>(out, count, options, threads, &stats);
+  }
+  if(path){
+    fclose(out);
+  }
+  print_generate_stats(&stats);
+  return 0;
+}
+
+
+
+// record_solve<BLOCK_DIM>(cells, out, steps) solves the board in cells, writing the trace
+// of every step of the search to out (see solve_trace.h), sets steps to the number of
+// steps and returns 1 if it was solved, 0 if it has no solution or -1 if the trace
+// could not be written
+
+// effects: produces output on out, mutates steps
+template <int BLOCK_DIM>
+int record_solve(const int *cells, FILE *out, long *steps){
+  sudoku::solver<BLOCK_DIM> board;
+  sudoku::solve_trace trace(out);
+  board.load(cells);
+  const bool solved = board.solve(&trace);
+  *steps = trace.steps();
+  return !trace.flush() ? -1 : solved ? 1 : 0;
+}
+
+
+
+// run_record(trace_path, cells, box_dim) solves the box_dim board in cells, tracing the
+// search to the file at trace_path, and reports the outcome on stderr. Returns the
+// process exit status
+
+// effects: produces output
+int run_record(const char *trace_path, const int *cells, int box_dim){
+  FILE *out = fopen(trace_path, "wb");
+  if(!out){
+    fprintf(stderr, "cannot open %s\n", trace_path);
+    return 1;
+  }
+  long steps = 0;
+  const int result = box_dim == 5 ? record_solve<5>(cells, out, &steps) :
+                     box_dim == 4 ? record_solve<4>(cells, out, &steps) :
+                     record_solve<3>(cells, out, &steps);
+  if(fclose(out) != 0 || result < 0){
+    fprintf(stderr, "cannot write %s\n", trace_path);
+    return 1;
+  }
+  fprintf(stderr, "%s: %ld steps traced to %s\n", result ? "solved" : "no solution", steps, trace_path);
+  return 0;
+}
+
+
+
+// run_record_file(trace_path, path) is run_record() on the first line of the file at path
+
+// effects: reads input, produces output
+int run_record_file(const char *trace_path, const char *path){
+  FILE *in = fopen(path, "rb");
+  if(!in){
+    fprintf(stderr, "cannot open %s\n", path);
+    return 1;
+  }
+  char line[1024];
+  const bool got = fgets(line, sizeof(line), in) != NULL;
+  fclose(in);
+  int len = got ? static_cast<int>(strcspn(line, "\r\n")) : 0;
+  int cells[625];
+  const int box_dim = parse_puzzle(line, len, cells);
+  if(!box_dim){
+    fprintf(stderr, "%s does not start with a puzzle\n", path);
+    return 1;
+  }
+  return run_record(trace_path, cells, box_dim);
+}
+
+
+
+// parse_symmetry(name, sym) sets sym to the symmetry called name and returns true, or
+// returns false if there is no such symmetry
+bool parse_symmetry(const char *name, sudoku::symmetry &sym){
+  const char *names[] = {"none", "rot", "mirror", "diag"};
+  for(int k = 0; k < 4; ++k){
+    if(strcmp(name, names[k]) == 0){
+      sym = static_cast<sudoku::symmetry>(k);
+      return true;
+    }
+  }
+  return false;
+}
+
+
+
+void print_usage(const char *name){
+  fprintf(stderr,
+          "usage: %s                        solve and print the built-in 16x16 board\n"
+          "       %s -b [-t n] [-p] [-n nodes] [-l ms] [-w [-d 3|4|5]] [file]\n"
+          "                                 solve one puzzle per line from file (default stdin)\n"
+          "                                 on n threads (default: one per core); with -p all\n"
+          "                                 threads search each puzzle together, otherwise\n"
+          "                                 puzzles needing more than -n search nodes or -l\n"
+          "                                 milliseconds are given up on. With -w the results\n"
+          "                                 are written as a binary stream of 9x9 (or -d 4\n"
+          "                                 16x16, -d 5 25x25) boards\n"
+          "       %s -x file\n"
+          "                                 decode the binary result stream in file to text\n"
+          "       %s -g n [-d 3|4] [-c clues] [-y none|rot|mirror|diag] [-s seed] [-t n] [file]\n"
+          "                                 write n puzzles with unique solutions to file\n"
+          "                                 (default stdout), 9x9 or with -d 4 16x16, removing\n"
+          "                                 clues down to -c (default: as few as possible)\n"
+          "       %s -u [-t n] [file]\n"
+          "                                 copy the lines of file (default stdin) to stdout,\n"
+          "                                 leaving out 9x9 puzzles equivalent to an earlier one\n"
+          "                                 under relabelling, row, column, band and stack\n"
+          "                                 swaps and transposition, and report how many\n"
+          "                                 distinct puzzles there are\n"
+          "       %s -r trace [file]\n"
+          "                                 solve the first puzzle of file (default: the built-in\n"
+          "                                 board), writing every step of the search to trace\n",
+          name, name, name, name, name, name);
+}
+
+
+
+int main(int argc, char **argv){
+  const char *trace_path = NULL;
+  if(argc > 1){
+    bool batch = false;
+    bool dedupe = false;
+    bool binary = false;
+    const char *decode_path = NULL;
+    const int cores = std::thread::hardware_concurrency();
+    int threads = cores > 0 ? cores : 1;
+    bool split = false;
+    const char *path = NULL;
+    long generate = 0;
+    generate_options options = {3, 0, sudoku::SYMMETRY_NONE, 1};
+    batch_limits limits = {0, 0};
+    bool valid = true;
+    for(int k = 1; k < argc; ++k){
+      if(strcmp(argv[k], "-b") == 0){
+        batch = true;
+      } else if(strcmp(argv[k], "-w") == 0){
+        binary = true;
+      } else if(strcmp(argv[k], "-x") == 0 && k + 1 < argc){
+        decode_path = argv[++k];
+      } else if(strcmp(argv[k], "-u") == 0){
+        dedupe = true;
+      } else if(strcmp(argv[k], "-g") == 0 && k + 1 < argc){
+        generate = atol(argv[++k]);
+      } else if(strcmp(argv[k], "-d") == 0 && k + 1 < argc){
+        options.box_dim = atoi(argv[++k]);
+      } else if(strcmp(argv[k], "-c") == 0 && k + 1 < argc){
+        options.target = atoi(argv[++k]);
+      } else if(strcmp(argv[k], "-y") == 0 && k + 1 < argc){
+        valid = parse_symmetry(argv[++k], options.sym) && valid;
+      } else if(strcmp(argv[k], "-s") == 0 && k + 1 < argc){
+        options.seed = strtoull(argv[++k], NULL, 10);
+      } else if(strcmp(argv[k], "-r") == 0 && k + 1 < argc){
+        trace_path = argv[++k];
+      } else if(strcmp(argv[k], "-n") == 0 && k + 1 < argc){
+        limits.max_nodes = atol(argv[++k]);
+      } else if(strcmp(argv[k], "-l") == 0 && k + 1 < argc){
+        limits.max_seconds = atof(argv[++k]) / 1000;
+      } else if(strcmp(argv[k], "-p") == 0){
+        split = true;
+      } else if(strcmp(argv[k], "-t") == 0 && k + 1 < argc){
+        threads = atoi(argv[++k]);
+      } else if(argv[k][0] != '-' && !path){
+        path = argv[k];
+      } else{
+        valid = false;
+        break;
+      }
+    }
+    if(valid && decode_path && !path && !batch && !binary && !dedupe && !generate &&
+       !trace_path){
+      return run_decode(decode_path);
+    }
+    valid = valid && !decode_path &&
+            (!binary || (batch && !split && result_board_bytes(options.box_dim)));
+    if(valid && threads >= 1 && dedupe && !batch && !generate && !trace_path){
+      return run_dedupe(path, threads);
+    }
+    valid = valid && !dedupe;
+    const bool record = valid && trace_path && !batch && !generate;
+    if(record && path){
+      return run_record_file(trace_path, path);
+    }
+    const bool limited = limits.max_nodes || limits.max_seconds > 0;
+    if(valid && threads >= 1 && batch && !generate && !(split && limited) &&
+       limits.max_nodes >= 0 && limits.max_seconds >= 0){
+      return run_batch(path, threads, split, limits, binary ? options.box_dim : 0);
+    }
+    if(valid && threads >= 1 && !batch && generate > 0 &&
+       (options.box_dim == 3 || options.box_dim == 4)){
+      return run_generate(path, generate, options, threads);
+    }
+    if(!record){
+      print_usage(argv[0]);
+      return 2;
+    }
+  }
+  int sudoku_grid[DIM][DIM] = {
+    {0,11,9,0,0,16,13,4,0,0,14,0,10,6,15,0},
+    {4,12,15,0,3,6,0,11,0,5,0,1,16,7,14,2},
+    {1,0,6,0,15,2,0,0,11,9,10,0,0,0,8,0},
+    {0,13,0,0,0,1,0,0,4,6,0,15,0,0,0,0},
+    {0,0,0,0,0,0,15,0,8,1,5,3,0,4,11,7},
+    {6,0,1,0,0,12,8,0,9,0,0,2,0,0,3,0},
+    {14,0,4,13,6,0,0,3,0,12,7,10,8,0,2,0},
+    {3,8,0,0,4,7,2,0,6,0,0,0,0,12,16,5},
+    {13,0,0,16,0,8,14,10,3,4,15,0,12,5,1,11},
+    {0,0,0,6,2,0,0,1,10,0,11,0,15,3,0,9},
+    {7,0,0,12,0,4,0,15,5,0,9,14,0,0,0,0},
+    {10,0,0,8,0,0,11,0,0,0,1,12,4,0,13,16},
+    {0,0,0,0,0,0,7,0,15,2,0,0,0,0,12,3},
+    {0,0,7,0,0,10,6,0,1,8,0,13,11,0,9,14},
+    {8,6,5,0,0,3,0,0,14,0,0,9,0,0,0,0},
+    {0,16,0,2,0,0,0,14,0,10,0,0,0,0,0,0}};
+  if(trace_path){
+    return run_record(trace_path, &sudoku_grid[0][0], BOX_DIM);
+  }
+  print_grid(sudoku_grid);
+  printf("\n");
+  if(sudoku_solver(sudoku_grid)){
+    print_grid(sudoku_grid);
+  } else{
+    printf("Error, sudoku_solver failed\n");
+  }
+}
+
+
+
+/*int sudoku_grid[DIM][DIM] = {{0,0,2,9,8,0,5,0,0},
+                         {4,0,0,0,7,0,0,1,3},
+                         {0,3,9,6,0,4,0,7,0},
+                         {2,0,0,0,5,6,4,0,0},
+                         {8,4,0,3,0,0,2,0,1},
+                         {9,0,7,0,0,1,0,8,6},
+                         {6,0,0,7,0,5,1,3,0},
+                         {0,9,1,4,0,0,0,0,5},
+                         {0,2,0,0,3,0,6,0,8}};*/
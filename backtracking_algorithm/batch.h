@@ -0,0 +1,836 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+// Line-per-puzzle batch solving. Every input line is one board written row by row with
+// one character per cell: 81 characters for 9x9, 256 for 16x16 and 625 for 25x25.
+// Numbers 1-9 are written as digits and 10 and up as letters ('A' = 10, 'B' = 11, ...),
+// and an empty cell is '.' or '0'. A line may also list the cells as numbers separated
+// by spaces, tabs, commas or '|' (as print_grid() writes them), with 0 or '.' for an
+// empty cell. Each solution is written back in the same format on its own line;
+// unsolvable or malformed lines, and lines given up on for running over their budget,
+// are echoed unchanged so that output line n always belongs to input line n.
+
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <vector>
+#include "../Visualizer/lane_solver.h"
+#include "../Visualizer/solver.h"
+#include "../Visualizer/thread_pool.h"
+#include "mapped_file.h"
+#include "result_stream.h"
+#include "parallel_search.h"
+
+// running totals for one batch run
+struct batch_stats{
+  long puzzles;
+  long solved;
+  long unsolved;
+  long malformed;
+  // puzzles given up on for running over the budget
+  long exhausted;
+  double seconds;
+};
+
+// the budget of each puzzle of a batch, each 0 for no limit
+struct batch_limits{
+  long max_nodes;
+  double max_seconds;
+};
+
+
+
+// box_dim_for_length(len) returns the block size of a board written with len cells, or
+// 0 if no supported board has that many
+
+// time: O(1)
+inline int box_dim_for_length(int len){
+  switch(len){
+    case 81: return 3;
+    case 256: return 4;
+    case 625: return 5;
+    default: return 0;
+  }
+}
+
+
+
+// cell_chars maps each character to the number it stands for in a board line, or to -1
+// if it cannot stand for a cell
+struct cell_chars{
+  signed char val[256];
+
+  cell_chars(){
+    memset(val, -1, sizeof(val));
+    val[static_cast<unsigned char>('.')] = 0;
+    for(int c = '0'; c <= '9'; ++c){
+      val[c] = static_cast<signed char>(c - '0');
+    }
+    for(int c = 'A'; c <= 'Z'; ++c){
+      val[c] = static_cast<signed char>(c - 'A' + 10);
+      val[c - 'A' + 'a'] = static_cast<signed char>(c - 'A' + 10);
+    }
+  }
+};
+
+
+
+// parse_puzzle(line, len, cells, numbers) reads the board written in the first len
+// characters of line, in either format, into cells and returns its block size, or
+// returns 0 if line is not a board. numbers is set to whether it was written as
+// separated numbers
+
+// requires: line must not be NULL, cells must hold 625 values
+
+// time: O(n) where n is len
+inline int parse_puzzle(const char *line, int len, int *cells, bool &numbers){
+  static const cell_chars chars;
+  numbers = false;
+  int box_dim = box_dim_for_length(len);
+  if(box_dim){
+    // one character per cell: fold the checks into one comparison per cell
+    const int side = box_dim * box_dim;
+    unsigned bad = 0;
+    for(int k = 0; k < len; ++k){
+      const int val = chars.val[static_cast<unsigned char>(line[k])];
+      bad |= static_cast<unsigned>(side - val) | static_cast<unsigned>(val);
+      cells[k] = val;
+    }
+    if(!(bad >> 31)){
+      return box_dim;
+    }
+  }
+  // separated numbers
+  int count = 0;
+  int k = 0;
+  while(k < len){
+    const char c = line[k];
+    if(c == ' ' || c == '\t' || c == ',' || c == '|'){
+      ++k;
+      continue;
+    }
+    if(count == 625){
+      return 0;
+    }
+    if(c == '.'){
+      cells[count++] = 0;
+      ++k;
+    } else if(c >= '0' && c <= '9'){
+      int val = 0;
+      for(; k < len && line[k] >= '0' && line[k] <= '9' && val <= 25; ++k){
+        val = 10 * val + line[k] - '0';
+      }
+      cells[count++] = val;
+    } else{
+      return 0;
+    }
+    if(k < len && line[k] != ' ' && line[k] != '\t' && line[k] != ',' && line[k] != '|'){
+      return 0;
+    }
+  }
+  box_dim = box_dim_for_length(count);
+  for(int cell = 0; box_dim && cell < count; ++cell){
+    if(cells[cell] > box_dim * box_dim){
+      return 0;
+    }
+  }
+  numbers = box_dim != 0;
+  return box_dim;
+}
+
+inline int parse_puzzle(const char *line, int len, int *cells){
+  bool numbers;
+  return parse_puzzle(line, len, cells, numbers);
+}
+
+
+
+// format_puzzle(cells, box_dim, out) writes the board in cells into out in line format,
+// without a newline
+
+// requires: cells must not be NULL, out must hold box_dim^4 characters
+
+// time: O(n) where n is the number of cells
+inline void format_puzzle(const int *cells, int box_dim, char *out){
+  const int len = box_dim * box_dim * box_dim * box_dim;
+  for(int k = 0; k < len; ++k){
+    const int val = cells[k];
+    out[k] = val == 0 ? '.' : val < 10 ? '0' + val : 'A' + val - 10;
+  }
+}
+
+
+
+// format_numbers(cells, box_dim, out) appends the board in cells to out as numbers
+// separated by spaces, without a newline
+
+// effects: mutates out
+
+// requires: cells must not be NULL
+
+// time: O(n) where n is the number of cells
+inline void format_numbers(const int *cells, int box_dim, std::vector<char> &out){
+  const int len = box_dim * box_dim * box_dim * box_dim;
+  for(int k = 0; k < len; ++k){
+    const int val = cells[k];
+    if(k){
+      out.push_back(' ');
+    }
+    if(val >= 10){
+      out.push_back(static_cast<char>('0' + val / 10));
+    }
+    out.push_back(static_cast<char>('0' + val % 10));
+  }
+}
+
+
+
+// solve_cells<BOX_DIM>(board, cells, search) loads cells into board, solves it (with
+// search if it is not NULL) and stores the solution back into cells, returning false if
+// there is none
+
+// effects: may mutate cells and search
+template <int BOX_DIM>
+bool solve_cells(sudoku::solver<BOX_DIM> &board, int *cells, parallel_search<BOX_DIM> *search){
+  if(!board.load(cells)){
+    return false;
+  }
+  if(search){
+    if(!search->solve(board)){
+      return false;
+    }
+  } else if(!board.solve()){
+    return false;
+  }
+  board.store(cells);
+  return true;
+}
+
+
+
+// solve_cells_within<BOX_DIM>(board, cells, limits, stats) is solve_cells(board, cells, NULL)
+// on a budget: it returns SOLVE_EXHAUSTED, leaving cells as they were, if the search runs
+// over limits (see solver::solve(options, stats)). The counters of the search, its
+// nodes at least, are left in stats
+
+// effects: may mutate cells, mutates stats
+template <int BOX_DIM>
+sudoku::solve_result solve_cells_within(sudoku::solver<BOX_DIM> &board, int *cells,
+                                        const batch_limits &limits, sudoku::search_stats &stats){
+  stats.nodes = 0;
+  if(!board.load(cells)){
+    return sudoku::SOLVE_UNSOLVABLE;
+  }
+  sudoku::solve_options options;
+  options.max_nodes = limits.max_nodes;
+  if(limits.max_seconds > 0){
+    options.set_timeout(limits.max_seconds);
+  }
+  const sudoku::solve_result result = board.solve(options, &stats);
+  if(result == sudoku::SOLVE_SOLVED){
+    board.store(cells);
+  }
+  return result;
+}
+
+
+
+// batch_solver keeps one warm solver per supported size and solves lines with them. 9x9
+// lines searched on one thread without a budget are held back until there are enough to
+// fill the lanes of a lane_solver, with their result lines reserved in the output, and
+// solved together. Lines solved into result records are each searched on their own, so
+// that their nodes and time can be recorded
+struct batch_solver{
+  static constexpr int LANES = sudoku::lane_solver::LANES;
+  sudoku::solver<3> board9;
+  sudoku::solver<4> board16;
+  sudoku::solver<5> board25;
+  sudoku::lane_solver lanes;
+  int cells[625];
+  // threads searching each single board, and the searches that do so if that is more
+  // than one, made when first needed (see parallel_search)
+  int search_threads;
+  parallel_search<3> *search9;
+  parallel_search<4> *search16;
+  parallel_search<5> *search25;
+  // the budget of each board; only kept by searches on one thread
+  batch_limits limits;
+  // the lines held back: where their result lines start in the output, their text and
+  // their cells
+  int held;
+  size_t held_at[LANES];
+  char held_text[LANES][81];
+  int held_cells[LANES * 81];
+  // if not 0, lines are solved into result records of boards with this block size (see
+  // result_stream.h) instead of result lines
+  int binary_dim;
+  sudoku::search_stats search;
+
+  batch_solver() : search_threads(1), search9(NULL), search16(NULL), search25(NULL), held(0),
+                   binary_dim(0){
+    limits.max_nodes = 0;
+    limits.max_seconds = 0;
+  }
+
+  ~batch_solver(){
+    delete search9;
+    delete search16;
+    delete search25;
+  }
+
+  bool limited() const{
+    return limits.max_nodes || limits.max_seconds > 0;
+  }
+
+  // solve_line(line, len, out, stats) solves the board on line (len characters, no
+  // newline) and appends the result line, newline included, to out
+
+  // effects: mutates out and stats
+  void solve_line(const char *line, int len, std::vector<char> &out, batch_stats &stats){
+    if(binary_dim){
+      solve_record(line, len, out, stats);
+      return;
+    }
+    if(len && line[len - 1] == '\r'){
+      --len;
+    }
+    const size_t at = out.size();
+    out.resize(at + len + 1);
+    char *dst = &out[at];
+    dst[len] = '\n';
+    if(!len){
+      return;
+    }
+    ++stats.puzzles;
+    bool numbers;
+    const int box_dim = parse_puzzle(line, len, cells, numbers);
+    bool solved = false;
+    if(box_dim == 3 && !numbers && search_threads <= 1 && !limited()){
+      held_at[held] = at;
+      memcpy(held_text[held], line, 81);
+      memcpy(held_cells + held * 81, cells, sizeof(int) * 81);
+      if(++held == LANES){
+        flush(out, stats);
+      }
+      return;
+    }
+    if(box_dim && search_threads <= 1 && limited()){
+      const sudoku::solve_result result =
+          box_dim == 3 ? solve_cells_within(board9, cells, limits, search) :
+          box_dim == 4 ? solve_cells_within(board16, cells, limits, search) :
+          solve_cells_within(board25, cells, limits, search);
+      if(result == sudoku::SOLVE_EXHAUSTED){
+        memcpy(dst, line, len);
+        ++stats.exhausted;
+        return;
+      }
+      solved = result == sudoku::SOLVE_SOLVED;
+    } else if(box_dim == 3){
+      solved = solve_cells(board9, cells, searcher(search9));
+    } else if(box_dim == 4){
+      solved = solve_cells(board16, cells, searcher(search16));
+    } else if(box_dim == 5){
+      solved = solve_cells(board25, cells, searcher(search25));
+    }
+    if(solved && numbers){
+      out.resize(at);
+      format_numbers(cells, box_dim, out);
+      out.push_back('\n');
+      ++stats.solved;
+    } else if(solved){
+      format_puzzle(cells, box_dim, dst);
+      ++stats.solved;
+    } else{
+      memcpy(dst, line, len);
+      ++(box_dim ? stats.unsolved : stats.malformed);
+    }
+  }
+
+  // searcher(search) returns search, made first if need be, if boards are searched on
+  // more than one thread and NULL otherwise
+  template <int BOX_DIM>
+  parallel_search<BOX_DIM> *searcher(parallel_search<BOX_DIM> *&search){
+    if(search_threads <= 1){
+      return NULL;
+    }
+    if(!search){
+      search = new parallel_search<BOX_DIM>(search_threads);
+    }
+    return search;
+  }
+
+  // solve_record(line, len, out, stats) solves the board on line (len characters, no
+  // newline) within limits and appends its result record to out. Blank lines and lines
+  // that are not binary_dim boards get a RESULT_MALFORMED record, so that record n
+  // always belongs to input line n
+
+  // effects: mutates out and stats
+  void solve_record(const char *line, int len, std::vector<char> &out, batch_stats &stats){
+    if(len && line[len - 1] == '\r'){
+      --len;
+    }
+    if(!len){
+      append_result(binary_dim, RESULT_MALFORMED, 0, 0, NULL, out);
+      return;
+    }
+    ++stats.puzzles;
+    if(parse_puzzle(line, len, cells) != binary_dim){
+      append_result(binary_dim, RESULT_MALFORMED, 0, 0, NULL, out);
+      ++stats.malformed;
+      return;
+    }
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    const sudoku::solve_result result =
+        binary_dim == 3 ? solve_cells_within(board9, cells, limits, search) :
+        binary_dim == 4 ? solve_cells_within(board16, cells, limits, search) :
+        solve_cells_within(board25, cells, limits, search);
+    const long micros = static_cast<long>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start).count());
+    const result_status status = result == sudoku::SOLVE_SOLVED ? RESULT_SOLVED :
+                                 result == sudoku::SOLVE_EXHAUSTED ? RESULT_TIMED_OUT :
+                                 RESULT_UNSOLVABLE;
+    append_result(binary_dim, status, search.nodes, micros, cells, out);
+    ++(status == RESULT_SOLVED ? stats.solved : status == RESULT_TIMED_OUT ? stats.exhausted :
+       stats.unsolved);
+  }
+
+  // flush(out, stats) solves the lines held back and fills in their result lines in out,
+  // which must be done before out is written
+
+  // effects: mutates out and stats
+  void flush(std::vector<char> &out, batch_stats &stats){
+    if(!held){
+      return;
+    }
+    bool solved[LANES];
+    lanes.solve(held_cells, held, solved);
+    for(int k = 0; k < held; ++k){
+      if(solved[k]){
+        format_puzzle(held_cells + k * 81, 3, &out[held_at[k]]);
+        ++stats.solved;
+      } else{
+        memcpy(&out[held_at[k]], held_text[k], 81);
+        ++stats.unsolved;
+      }
+    }
+    held = 0;
+  }
+};
+
+
+
+// solve_batch(in, out, search_threads, limits, binary_dim, stats) solves every line of
+// in, one after the other, and writes the result lines to out, reading and writing in
+// large blocks. Each board is searched by search_threads threads, within limits if that
+// is one. If binary_dim is not 0, out gets a result stream of boards with that block
+// size instead (see result_stream.h)
+
+// effects: reads in, produces output on out, mutates stats
+
+// requires: in, out and stats must not be NULL
+
+// time: O(n) solves where n is the number of lines
+inline void solve_batch(FILE *in, FILE *out, int search_threads, const batch_limits &limits,
+                        int binary_dim, batch_stats *stats){
+  const size_t BLOCK = 1 << 20;
+  std::vector<char> buffer(BLOCK);
+  std::vector<char> output;
+  output.reserve(2 * BLOCK);
+  batch_solver *solver = new batch_solver();
+  solver->search_threads = search_threads;
+  solver->limits = limits;
+  solver->binary_dim = binary_dim;
+  if(binary_dim){
+    append_result_header(binary_dim, output);
+  }
+  memset(stats, 0, sizeof(*stats));
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  size_t filled = 0;
+  for(;;){
+    if(filled == buffer.size()){
+      buffer.resize(2 * buffer.size());
+    }
+    const size_t got = fread(&buffer[filled], 1, buffer.size() - filled, in);
+    filled += got;
+    const bool eof = got == 0;
+    size_t begin = 0;
+    for(;;){
+      const char *nl = static_cast<const char *>(memchr(buffer.data() + begin, '\n', filled - begin));
+      if(!nl){
+        break;
+      }
+      const size_t end = nl - buffer.data();
+      solver->solve_line(buffer.data() + begin, end - begin, output, *stats);
+      begin = end + 1;
+    }
+    if(eof && begin < filled){
+      solver->solve_line(buffer.data() + begin, filled - begin, output, *stats);
+      begin = filled;
+    }
+    memmove(buffer.data(), buffer.data() + begin, filled - begin);
+    filled -= begin;
+    if(output.size() >= BLOCK || eof){
+      solver->flush(output, *stats);
+      fwrite(output.data(), 1, output.size(), out);
+      output.clear();
+    }
+    if(eof){
+      break;
+    }
+  }
+  fflush(out);
+  delete solver;
+  stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+
+// solve_mapped_lines(solver, data, begin, end, output, stats) solves the lines of data
+// in [begin, end), which must start a line and end one, where they lie in data
+
+// effects: mutates solver, output and stats
+inline void solve_mapped_lines(batch_solver &solver, const char *data, size_t begin, size_t end,
+                               std::vector<char> &output, batch_stats &stats){
+  while(begin < end){
+    const size_t next = line_end(data, end, begin);
+    solver.solve_line(data + begin, static_cast<int>(next - begin - (data[next - 1] == '\n')),
+                      output, stats);
+    begin = next;
+  }
+}
+
+
+
+// slice_queue solves slices of whole lines on a pool of workers, each with a batch_solver
+// of its own, and writes the slice outputs in the order the slices were queued. Slices
+// are queued while earlier ones are still being solved, so a slow puzzle holds up the
+// output behind it but never the workers: they go on with the slices queued after it
+class slice_queue{
+  public:
+  // slice_queue(threads, limits, binary_dim, out) starts threads workers that solve
+  // within limits and write text, or result records of binary_dim boards, to out
+  slice_queue(int threads, const batch_limits &limits, int binary_dim, FILE *out) :
+      pool(threads), solvers(pool.size()), worker_stats(pool.size()), out(out), first(0),
+      unwritten(0){
+    for(int id = 0; id < pool.size(); ++id){
+      solvers[id] = new batch_solver();
+      solvers[id]->limits = limits;
+      solvers[id]->binary_dim = binary_dim;
+      memset(&worker_stats[id], 0, sizeof(batch_stats));
+    }
+    job = [this](int seq, int worker){ solve(seq, worker); };
+    pool.begin(job);
+  }
+
+  ~slice_queue(){
+    pool.wait();
+    for(size_t id = 0; id < solvers.size(); ++id){
+      delete solvers[id];
+    }
+  }
+
+  // queue(data, begin, end) queues the lines of data in [begin, end), which must start a
+  // line and end one, for the workers
+
+  // requires: data must stay valid until the slice has been written
+  void queue(const char *data, size_t begin, size_t end){
+    slice next = {data, begin, end, std::vector<char>(), false};
+    int seq;
+    {
+      std::lock_guard<std::mutex> hold(lock);
+      seq = static_cast<int>(first + slices.size());
+      slices.push_back(next);
+      unwritten += end - begin;
+    }
+    pool.post(seq);
+  }
+
+  // write(most) writes the outputs of the finished slices at the front of the queue, in
+  // order, waiting for more to finish until at most most bytes of input are queued and
+  // unwritten
+
+  // effects: produces output
+  void write(size_t most){
+    std::vector<char> output;
+    std::unique_lock<std::mutex> hold(lock);
+    for(;;){
+      while(!slices.empty() && slices.front().done){
+        output.swap(slices.front().output);
+        unwritten -= slices.front().end - slices.front().begin;
+        slices.pop_front();
+        ++first;
+        hold.unlock();
+        fwrite(output.data(), 1, output.size(), out);
+        hold.lock();
+      }
+      if(unwritten <= most){
+        return;
+      }
+      finished.wait(hold);
+    }
+  }
+
+  // written() returns the number of slices written so far
+  long written(){
+    std::lock_guard<std::mutex> hold(lock);
+    return first;
+  }
+
+  // queued() returns the number of slices queued so far
+  long queued(){
+    std::lock_guard<std::mutex> hold(lock);
+    return first + static_cast<long>(slices.size());
+  }
+
+  // finish(stats) writes every slice still queued and adds the workers' counts to stats
+
+  // effects: produces output, mutates stats
+  void finish(batch_stats *stats){
+    write(0);
+    fflush(out);
+    for(size_t id = 0; id < solvers.size(); ++id){
+      stats->puzzles += worker_stats[id].puzzles;
+      stats->solved += worker_stats[id].solved;
+      stats->unsolved += worker_stats[id].unsolved;
+      stats->malformed += worker_stats[id].malformed;
+      stats->exhausted += worker_stats[id].exhausted;
+    }
+  }
+
+
+
+  private:
+  struct slice{
+    const char *data;
+    size_t begin;
+    size_t end;
+    std::vector<char> output;
+    bool done;
+  };
+
+  work_stealing_pool pool;
+  std::vector<batch_solver *> solvers;
+  std::vector<batch_stats> worker_stats;
+  std::function<void(int, int)> job;
+  FILE *out;
+  // guards everything below; finished is signalled as each slice is solved
+  std::mutex lock;
+  std::condition_variable finished;
+  // the slices queued and not yet written, the first of them numbered first. A deque
+  // keeps the slices in place while others are queued and written
+  std::deque<slice> slices;
+  long first;
+  // the bytes of input in slices
+  size_t unwritten;
+
+  // solve(seq, worker) solves slice seq on worker
+  void solve(int seq, int worker){
+    slice *work;
+    {
+      std::lock_guard<std::mutex> hold(lock);
+      work = &slices[seq - first];
+    }
+    solve_mapped_lines(*solvers[worker], work->data, work->begin, work->end, work->output,
+                       worker_stats[worker]);
+    solvers[worker]->flush(work->output, worker_stats[worker]);
+    {
+      std::lock_guard<std::mutex> hold(lock);
+      work->done = true;
+    }
+    finished.notify_one();
+  }
+
+  slice_queue(const slice_queue &);
+  slice_queue &operator=(const slice_queue &);
+};
+
+
+
+// solve_batch_parallel(in, out, threads, limits, binary_dim, stats) is solve_batch()
+// spread over a pool of threads workers, each board on one thread and within limits.
+// Input is read in blocks, and each block is cut at newlines into slices for a
+// slice_queue. Reading goes on while the slices of earlier blocks are solved, up to
+// AHEAD bytes past the oldest slice not yet written, so a slow puzzle leaves no worker
+// idle; the outputs are written in input order
+
+// effects: reads in, produces output on out, mutates stats
+
+// requires: in, out and stats must not be NULL
+
+// time: O(n / t) solves where n is the number of lines and t is threads
+inline void solve_batch_parallel(FILE *in, FILE *out, int threads, const batch_limits &limits,
+                                 int binary_dim, batch_stats *stats){
+  const size_t BLOCK = 1 << 20;
+  const size_t SLICE = 8 << 10;
+  const size_t AHEAD = 32 << 20;
+  memset(stats, 0, sizeof(*stats));
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  if(binary_dim){
+    std::vector<char> header;
+    append_result_header(binary_dim, header);
+    fwrite(header.data(), 1, header.size(), out);
+  }
+  slice_queue *slices = new slice_queue(threads, limits, binary_dim, out);
+  // the blocks with slices not yet written, and the number of slices queued once each
+  // was cut up
+  std::deque<std::vector<char> > blocks;
+  std::deque<long> block_ends;
+  std::vector<char> carry;
+
+  for(bool eof = false; !eof;){
+    // the block starts with the unfinished line the last one ended on
+    std::vector<char> block;
+    block.swap(carry);
+    const size_t kept = block.size();
+    block.resize(kept + BLOCK);
+    const size_t got = fread(&block[kept], 1, BLOCK, in);
+    eof = got == 0;
+    size_t end = kept + got;
+    if(!eof){
+      while(end > 0 && block[end - 1] != '\n'){
+        --end;
+      }
+    }
+    carry.assign(block.begin() + end, block.begin() + kept + got);
+    block.resize(end);
+    if(end){
+      for(size_t begin = 0; begin < end;){
+        const size_t next = line_end(block.data(), end, (begin + SLICE < end ? begin + SLICE : end) - 1);
+        slices->queue(block.data(), begin, next);
+        begin = next;
+      }
+      blocks.push_back(std::vector<char>());
+      blocks.back().swap(block);
+      block_ends.push_back(slices->queued());
+    }
+    slices->write(AHEAD);
+    const long written = slices->written();
+    while(!block_ends.empty() && block_ends.front() <= written){
+      blocks.pop_front();
+      block_ends.pop_front();
+    }
+  }
+  slices->finish(stats);
+  delete slices;
+  stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+
+// solve_batch_mapped(data, size, out, threads, split, limits, binary_dim, stats) is
+// solve_batch() (if split is true or threads is one) or solve_batch_parallel() on the
+// size bytes of a mapped file, with every line parsed where it lies in the map. Across
+// threads, the map is cut at newlines into slices for a slice_queue, which the workers
+// find the lines of and solve. The map needs no reading, so slices are queued up to
+// WINDOW bytes past the oldest one not yet written, however slow it is, and the slice
+// outputs are written in input order
+
+// effects: produces output on out, mutates stats
+
+// requires: out and stats must not be NULL, data must hold size bytes
+
+// time: O(n / t) solves where n is the number of lines and t is threads
+inline void solve_batch_mapped(const char *data, size_t size, FILE *out, int threads, bool split,
+                               const batch_limits &limits, int binary_dim, batch_stats *stats){
+  const size_t WINDOW = 8 << 20;
+  const size_t SLICE = 16 << 10;
+  memset(stats, 0, sizeof(*stats));
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::vector<char> header;
+  if(binary_dim){
+    append_result_header(binary_dim, header);
+  }
+
+  if(split || threads == 1){
+    batch_solver *solver = new batch_solver();
+    solver->search_threads = threads;
+    solver->limits = limits;
+    solver->binary_dim = binary_dim;
+    std::vector<char> output(header);
+    output.reserve(2 * WINDOW);
+    for(size_t begin = 0; begin < size;){
+      const size_t end = line_end(data, size, (begin + SLICE < size ? begin + SLICE : size) - 1);
+      solve_mapped_lines(*solver, data, begin, end, output, *stats);
+      begin = end;
+      if(output.size() >= WINDOW){
+        solver->flush(output, *stats);
+        fwrite(output.data(), 1, output.size(), out);
+        output.clear();
+      }
+    }
+    solver->flush(output, *stats);
+    fwrite(output.data(), 1, output.size(), out);
+    fflush(out);
+    delete solver;
+    stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return;
+  }
+
+  if(!header.empty()){
+    fwrite(header.data(), 1, header.size(), out);
+  }
+  slice_queue *slices = new slice_queue(threads, limits, binary_dim, out);
+  for(size_t begin = 0; begin < size;){
+    const size_t end = line_end(data, size, (begin + SLICE < size ? begin + SLICE : size) - 1);
+    slices->queue(data, begin, end);
+    begin = end;
+    slices->write(WINDOW);
+  }
+  slices->finish(stats);
+  delete slices;
+  stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+
+// decode_results(reader, out) writes the records of the result stream open in reader to
+// out, one line each: the board in batch line format ('-' if the line was malformed),
+// the status, the search nodes and the solve time in microseconds
+
+// effects: produces output on out
+
+// requires: out must not be NULL
+inline void decode_results(const result_reader &reader, FILE *out){
+  const char *names[] = {"solved", "unsolvable", "timeout", "malformed"};
+  const int box_dim = reader.board_box_dim();
+  const int len = box_dim * box_dim * box_dim * box_dim;
+  result_record *record = new result_record();
+  std::vector<char> line(len + 64);
+  for(size_t k = 0; k < reader.size(); ++k){
+    reader.read(k, *record);
+    int at = 1;
+    if(record->status == RESULT_MALFORMED){
+      line[0] = '-';
+    } else{
+      format_puzzle(record->cells, box_dim, line.data());
+      at = len;
+    }
+    at += snprintf(line.data() + at, line.size() - at, " %s %ld %ld\n",
+                   record->status <= RESULT_MALFORMED ? names[record->status] : "unknown",
+                   record->nodes, record->micros);
+    fwrite(line.data(), 1, at, out);
+  }
+  delete record;
+}
+
+
+
+// print_batch_stats(stats) reports the totals and the throughput of a batch on stderr
+
+// effects: produces output
+inline void print_batch_stats(const batch_stats *stats){
+  fprintf(stderr, "%ld puzzles (%ld solved, %ld unsolvable, %ld malformed", stats->puzzles,
+          stats->solved, stats->unsolved, stats->malformed);
+  if(stats->exhausted){
+    fprintf(stderr, ", %ld over budget", stats->exhausted);
+  }
+  fprintf(stderr, ") in %.3f s, %.0f puzzles/s\n", stats->seconds,
+          stats->seconds > 0 ? stats->puzzles / stats->seconds : 0.0);
+}
+
+#endif // BATCH_H
@@ -0,0 +1,180 @@
+#ifndef DEDUPE_H
+#define DEDUPE_H
+
+// Batch deduplication. Every 9x9 line is reduced to its canonical form (see
+// canonical.h), and only the first line of each class of equivalent puzzles is written
+// out, so a batch can be cut down to its distinct puzzles before it is solved. Lines
+// that are not 9x9 boards, or have no canonical form, are written out unchanged, and
+// blank lines are dropped.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+#include <unordered_set>
+#include <vector>
+#include "../Visualizer/canonical.h"
+#include "../Visualizer/packed_board.h"
+#include "../Visualizer/thread_pool.h"
+#include "batch.h"
+
+// running totals for one deduplication run
+struct dedupe_stats{
+  long puzzles;
+  // the lines written out: distinct 9x9 puzzles and every line passed through
+  long distinct;
+  // lines passed through: other board sizes, malformed lines and boards with no form
+  long passed;
+  double seconds;
+};
+
+
+
+// packed_index_hasher and packed_index_equal hash and compare the boards of a
+// packed_boards container by their index, so a set of indices can stand for a set of
+// boards held back to back
+struct packed_index_hasher{
+  const sudoku::packed_boards<3> *boards;
+
+  size_t operator()(std::uint32_t k) const{
+    return sudoku::packed_board<3>::hasher()((*boards)[k]);
+  }
+};
+
+struct packed_index_equal{
+  const sudoku::packed_boards<3> *boards;
+
+  bool operator()(std::uint32_t a, std::uint32_t b) const{
+    return (*boards)[a] == (*boards)[b];
+  }
+};
+
+
+
+// dedupe_batch(in, out, threads, stats) writes the lines of in to out, leaving out every
+// 9x9 puzzle equivalent to one written before. The canonical forms of each block of
+// input are found on a pool of threads workers, and the lines then kept in order
+
+// effects: reads in, produces output on out, mutates stats
+
+// requires: in, out and stats must not be NULL
+
+// time: O(n / t) canonicalizations where n is the number of lines and t is threads
+inline void dedupe_batch(FILE *in, FILE *out, int threads, dedupe_stats *stats){
+  const size_t BLOCK = 8 << 20;
+  const int CHUNK_LINES = 256;
+  work_stealing_pool pool(threads);
+  std::vector<sudoku::canonicalizer *> canons(pool.size());
+  for(int id = 0; id < pool.size(); ++id){
+    canons[id] = new sudoku::canonicalizer();
+  }
+  std::vector<char> buffer(BLOCK);
+  std::vector<size_t> starts;
+  // the canonical key of each line of the block, if keyed[k] is set; otherwise the line
+  // is passed through
+  std::vector<sudoku::packed_board<3> > keys;
+  std::vector<char> keyed;
+  // the canonical key of every distinct puzzle written so far, and their indices
+  sudoku::packed_boards<3> distinct;
+  const packed_index_hasher hasher = {&distinct};
+  const packed_index_equal equal = {&distinct};
+  std::unordered_set<std::uint32_t, packed_index_hasher, packed_index_equal> seen(0, hasher, equal);
+  std::vector<char> output;
+  memset(stats, 0, sizeof(*stats));
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  size_t filled = 0;
+  bool eof = false;
+  while(!eof){
+    if(filled == buffer.size()){
+      buffer.resize(2 * buffer.size());
+    }
+    const size_t got = fread(&buffer[filled], 1, buffer.size() - filled, in);
+    filled += got;
+    eof = got == 0;
+
+    // line k of the block spans [starts[k], starts[k + 1] - 1), newline excluded
+    starts.clear();
+    size_t begin = 0;
+    for(;;){
+      const char *nl = static_cast<const char *>(memchr(buffer.data() + begin, '\n', filled - begin));
+      if(!nl){
+        break;
+      }
+      starts.push_back(begin);
+      begin = nl - buffer.data() + 1;
+    }
+    if(eof && begin < filled){
+      starts.push_back(begin);
+      begin = filled + 1;
+    }
+    const size_t consumed = begin < filled ? begin : filled;
+    starts.push_back(begin);
+    const int lines = static_cast<int>(starts.size()) - 1;
+    const int chunks = (lines + CHUNK_LINES - 1) / CHUNK_LINES;
+    keys.resize(lines);
+    keyed.assign(lines, 0);
+
+    pool.run(chunks, [&](int chunk, int worker){
+      const int last = (chunk + 1) * CHUNK_LINES < lines ? (chunk + 1) * CHUNK_LINES : lines;
+      int cells[625];
+      sudoku::canonical_form form;
+      for(int k = chunk * CHUNK_LINES; k < last; ++k){
+        size_t len = starts[k + 1] - 1 - starts[k];
+        if(len && buffer[starts[k] + len - 1] == '\r'){
+          --len;
+        }
+        if(parse_puzzle(buffer.data() + starts[k], static_cast<int>(len), cells) == 3 &&
+           canons[worker]->canonicalize(cells, form)){
+          keys[k] = form.key();
+          keyed[k] = 1;
+        }
+      }
+    });
+
+    output.clear();
+    for(int k = 0; k < lines; ++k){
+      const char *line = buffer.data() + starts[k];
+      const size_t len = starts[k + 1] - 1 - starts[k];
+      if(!len || (len == 1 && line[0] == '\r')){
+        continue;
+      }
+      ++stats->puzzles;
+      if(!keyed[k]){
+        ++stats->passed;
+      } else{
+        distinct.push_back(keys[k]);
+        if(!seen.insert(static_cast<std::uint32_t>(distinct.size() - 1)).second){
+          distinct.pop_back();
+          continue;
+        }
+      }
+      ++stats->distinct;
+      output.insert(output.end(), line, line + len);
+      output.push_back('\n');
+    }
+    fwrite(output.data(), 1, output.size(), out);
+
+    memmove(buffer.data(), buffer.data() + consumed, filled - consumed);
+    filled -= consumed;
+  }
+  fflush(out);
+  for(int id = 0; id < pool.size(); ++id){
+    delete canons[id];
+  }
+  stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+
+// print_dedupe_stats(stats) reports the totals and the throughput of a deduplication on
+// stderr
+
+// effects: produces output
+inline void print_dedupe_stats(const dedupe_stats *stats){
+  fprintf(stderr, "%ld puzzles, %ld distinct (%ld passed through) in %.3f s, %.0f puzzles/s\n",
+          stats->puzzles, stats->distinct, stats->passed, stats->seconds,
+          stats->seconds > 0 ? stats->puzzles / stats->seconds : 0.0);
+}
+
+#endif // DEDUPE_H
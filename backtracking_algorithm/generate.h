@@ -0,0 +1,129 @@
+#ifndef GENERATE_H
+#define GENERATE_H
+
+// Bulk puzzle generation. Puzzles with a unique solution are written one per line in the
+// batch line format (see batch.h). Puzzle k is made by a generator seeded from the run's
+// seed and k alone, so a run gives the same file whatever the number of threads.
+
+#include <cstdint>
+#include <cstdio>
+#include <chrono>
+#include <vector>
+#include "../Visualizer/generator.h"
+#include "../Visualizer/thread_pool.h"
+#include "batch.h"
+
+// what to generate
+struct generate_options{
+  int box_dim;
+  // clues to stop removing at; 0 removes as many as uniqueness allows
+  int target;
+  sudoku::symmetry sym;
+  std::uint64_t seed;
+};
+
+// running totals for one generation run
+struct generate_stats{
+  long puzzles;
+  long clues;
+  double seconds;
+};
+
+
+
+// puzzle_seed(seed, index) returns the generator seed of puzzle index of a run seeded
+// with seed (a splitmix64 step, so nearby indexes give unrelated seeds)
+
+// time: O(1)
+inline std::uint64_t puzzle_seed(std::uint64_t seed, long index){
+  std::uint64_t z = seed + (static_cast<std::uint64_t>(index) + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+
+
+// generate_range<BOX_DIM>(maker, first, last, options, out, stats) appends puzzles
+// first to last - 1 of the run, one line each, to out
+
+// effects: mutates maker, out and stats
+template <int BOX_DIM>
+void generate_range(sudoku::generator<BOX_DIM> &maker, long first, long last,
+                    const generate_options &options, std::vector<char> &out, generate_stats &stats){
+  const int cells_len = BOX_DIM * BOX_DIM * BOX_DIM * BOX_DIM;
+  int cells[cells_len];
+  for(long index = first; index < last; ++index){
+    maker.reseed(puzzle_seed(options.seed, index));
+    stats.clues += maker.generate(cells, options.target, options.sym);
+    ++stats.puzzles;
+    const size_t at = out.size();
+    out.resize(at + cells_len + 1);
+    format_puzzle(cells, BOX_DIM, &out[at]);
+    out[at + cells_len] = '\n';
+  }
+}
+
+
+
+// generate_puzzles<BOX_DIM>(out, count, options, threads, stats) writes count puzzles to
+// out, generated in chunks on a pool of threads workers and written in order
+
+// effects: produces output on out, mutates stats
+
+// requires: out and stats must not be NULL
+
+// time: O(n / t) generations where n is count and t is threads
+template <int BOX_DIM>
+void generate_puzzles(FILE *out, long count, const generate_options &options, int threads,
+                      generate_stats *stats){
+  const int CHUNK_PUZZLES = 64;
+  work_stealing_pool pool(threads);
+  std::vector<sudoku::generator<BOX_DIM> *> makers(pool.size());
+  std::vector<generate_stats> worker_stats(pool.size());
+  for(int id = 0; id < pool.size(); ++id){
+    makers[id] = new sudoku::generator<BOX_DIM>(options.seed);
+    worker_stats[id].puzzles = worker_stats[id].clues = 0;
+  }
+  // enough chunks per round to keep every worker busy, few enough to bound the memory
+  const int round_chunks = 16 * pool.size();
+  std::vector<std::vector<char> > outputs(round_chunks);
+  const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+  for(long done = 0; done < count; ){
+    const long round = count - done < static_cast<long>(round_chunks) * CHUNK_PUZZLES ?
+                       count - done : static_cast<long>(round_chunks) * CHUNK_PUZZLES;
+    const int chunks = static_cast<int>((round + CHUNK_PUZZLES - 1) / CHUNK_PUZZLES);
+    pool.run(chunks, [&](int chunk, int worker){
+      const long first = done + static_cast<long>(chunk) * CHUNK_PUZZLES;
+      const long last = first + CHUNK_PUZZLES < done + round ? first + CHUNK_PUZZLES : done + round;
+      outputs[chunk].clear();
+      generate_range(*makers[worker], first, last, options, outputs[chunk], worker_stats[worker]);
+    });
+    for(int chunk = 0; chunk < chunks; ++chunk){
+      fwrite(outputs[chunk].data(), 1, outputs[chunk].size(), out);
+    }
+    done += round;
+  }
+  fflush(out);
+  stats->puzzles = stats->clues = 0;
+  for(int id = 0; id < pool.size(); ++id){
+    stats->puzzles += worker_stats[id].puzzles;
+    stats->clues += worker_stats[id].clues;
+    delete makers[id];
+  }
+  stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+
+
+// print_generate_stats(stats) reports the totals and the throughput of a run on stderr
+
+// effects: produces output
+inline void print_generate_stats(const generate_stats *stats){
+  fprintf(stderr, "%ld puzzles (%.1f clues on average) in %.3f s, %.0f puzzles/s\n",
+          stats->puzzles, stats->puzzles ? static_cast<double>(stats->clues) / stats->puzzles : 0.0,
+          stats->seconds, stats->seconds > 0 ? stats->puzzles / stats->seconds : 0.0);
+}
+
+#endif // GENERATE_H
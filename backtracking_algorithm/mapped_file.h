@@ -0,0 +1,114 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+// Read-only memory maps of input files, so that a batch is parsed straight from the
+// mapped pages instead of being copied through a read buffer. Where there is no mmap,
+// or the input is not a regular file (stdin, a pipe), open() fails and the caller reads
+// with stdio instead.
+
+#include <cstddef>
+#include <cstring>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define MAPPED_FILE_POSIX
+#endif
+
+class mapped_file{
+  public:
+  mapped_file() : bytes(NULL), length(0){}
+
+  ~mapped_file(){
+    close();
+  }
+
+
+
+  // open(path) maps the whole file at path and returns true, or returns false if it
+  // cannot be opened or mapped
+
+  // effects: unmaps the file mapped before, if any
+
+  // requires: path must not be NULL
+  bool open(const char *path){
+    close();
+#ifdef MAPPED_FILE_POSIX
+    const int fd = ::open(path, O_RDONLY);
+    if(fd < 0){
+      return false;
+    }
+    struct stat info;
+    if(fstat(fd, &info) != 0 || !S_ISREG(info.st_mode)){
+      ::close(fd);
+      return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if(length){
+      void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(map == MAP_FAILED){
+        ::close(fd);
+        length = 0;
+        return false;
+      }
+      madvise(map, length, MADV_SEQUENTIAL);
+      bytes = static_cast<const char *>(map);
+    }
+    // the mapping stays valid once the descriptor is closed
+    ::close(fd);
+    return true;
+#else
+    (void)path;
+    return false;
+#endif
+  }
+
+  // close() unmaps the file, if one is mapped
+  void close(){
+#ifdef MAPPED_FILE_POSIX
+    if(bytes){
+      munmap(const_cast<char *>(bytes), length);
+    }
+#endif
+    bytes = NULL;
+    length = 0;
+  }
+
+  // data() returns the mapped bytes, or NULL for an empty file
+  const char *data() const{
+    return bytes;
+  }
+
+  size_t size() const{
+    return length;
+  }
+
+
+
+  private:
+  const char *bytes;
+  size_t length;
+
+  mapped_file(const mapped_file &);
+  mapped_file &operator=(const mapped_file &);
+};
+
+
+
+// line_end(data, size, at) returns the position just past the first newline at or after
+// at in the size bytes of data, or size if there is none, so that slices of a map cut at
+// line_end() positions hold whole lines
+
+// requires: at <= size
+
+// time: O(n) where n is the length of the line at at
+inline size_t line_end(const char *data, size_t size, size_t at){
+  if(at >= size){
+    return size;
+  }
+  const char *nl = static_cast<const char *>(memchr(data + at, '\n', size - at));
+  return nl ? nl - data + 1 : size;
+}
+
+#endif // MAPPED_FILE_H
@@ -0,0 +1,201 @@
+#ifndef PARALLEL_SEARCH_H
+#define PARALLEL_SEARCH_H
+
+// Parallel search of a single board. The top of the search tree is expanded breadth
+// first into independent subproblems (a copy of the solver state plus the candidates
+// still to try at one cell), which the threads of a work_stealing_pool then search. The
+// pool lives as long as the search, so solving board after board starts no threads. A
+// thread that runs out of work asks for more, and the busy threads split their next
+// branching cell with it through search_hooks. The first thread to find a solution stops
+// all the others, and so does the first to run out of time.
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
+#include "../Visualizer/solver.h"
+#include "../Visualizer/thread_pool.h"
+
+template <int BOX_DIM>
+class parallel_search : public sudoku::search_hooks<BOX_DIM>{
+  public:
+  typedef sudoku::solver<BOX_DIM> solver_type;
+  typedef typename solver_type::mask_t mask_t;
+
+  // parallel_search(threads) prepares a search on threads threads (at least one)
+  explicit parallel_search(int threads) : pool(threads), threads(pool.size()){
+    waiting = 0;
+    busy = 0;
+    pending = 0;
+    found = false;
+    exhausted = false;
+  }
+
+
+
+  // solve(board) returns true and solves board if it can be solved and returns false
+  // otherwise, searching with all the threads
+
+  // effects: may mutate board
+
+  // requires: board must have been loaded
+  bool solve(solver_type &board){
+    return solve(board, sudoku::solve_options()) == sudoku::SOLVE_SOLVED;
+  }
+
+
+
+  // solve(board, options) is solve(board) within the deadline and the cancel flags of
+  // options (its node limit is left unused, the nodes being spread over the threads). It
+  // returns SOLVE_SOLVED with board solved, SOLVE_UNSOLVABLE, or SOLVE_EXHAUSTED with
+  // board as it was if the budget ran out first
+
+  // effects: may mutate board
+
+  // requires: board must have been loaded
+  sudoku::solve_result solve(solver_type &board, const sudoku::solve_options &options){
+    this->stop = false;
+    found = false;
+    exhausted = false;
+    limits = options;
+    limits.max_nodes = 0;
+    tasks.clear();
+    pending = 0;
+    board.set_hooks(NULL);
+    const int mark = board.trail_size();
+    if(!board.propagate()){
+      board.undo(mark);
+      return sudoku::SOLVE_UNSOLVABLE;
+    }
+    const int root = board.next_cell(0);
+    if(root == solver_type::FULL){
+      return sudoku::SOLVE_SOLVED;
+    }
+    tasks.push_back(task(board, root, board.candidates(root)));
+    if(!expand(4 * threads)){
+      // the expansion ran into a solution
+      board = result;
+      board.set_hooks(NULL);
+      return sudoku::SOLVE_SOLVED;
+    }
+    pending = tasks.size();
+
+    pool.run(threads, [this](int, int){ worker_loop(); });
+    if(!found){
+      board.undo(mark);
+      return exhausted ? sudoku::SOLVE_EXHAUSTED : sudoku::SOLVE_UNSOLVABLE;
+    }
+    board = result;
+    board.set_hooks(NULL);
+    return sudoku::SOLVE_SOLVED;
+  }
+
+
+
+  // want_work() is true while more threads are waiting than there are queued subproblems
+  bool want_work() const{
+    return waiting.load(std::memory_order_relaxed) > pending.load(std::memory_order_relaxed);
+  }
+
+  // donate(state, cell, cands) queues the given candidates of cell in state as a new
+  // subproblem and wakes a waiting thread
+  void donate(const solver_type &state, int cell, mask_t cands){
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      tasks.push_back(task(state, cell, cands));
+      ++pending;
+    }
+    wake.notify_one();
+  }
+
+
+
+  private:
+  struct task{
+    solver_type state;
+    int cell;
+    mask_t cands;
+
+    task(const solver_type &state, int cell, mask_t cands) : state(state), cell(cell), cands(cands){}
+  };
+
+  work_stealing_pool pool;
+  const int threads;
+  std::deque<task> tasks;
+  std::mutex mutex;
+  std::condition_variable wake;
+  std::atomic<int> waiting;
+  std::atomic<int> pending;
+  int busy;
+  bool found;
+  // the budget of the solve running, with no node limit, and whether a thread ran out of it
+  sudoku::solve_options limits;
+  bool exhausted;
+  solver_type result;
+
+  // expand(target) splits the queued subproblems breadth first, one per candidate, until
+  // there are at least target of them or they have all been split 3 times. Returns false
+  // (with the solution in result) if a split solves the board outright
+  bool expand(size_t target){
+    for(int level = 0; level < 3 && !tasks.empty() && tasks.size() < target; ++level){
+      const size_t count = tasks.size();
+      for(size_t k = 0; k < count; ++k){
+        task &parent = tasks.front();
+        for(mask_t cands = parent.cands; cands; cands &= cands - 1){
+          solver_type child = parent.state;
+          child.assign(parent.cell, solver_type::lowest(cands) + 1);
+          if(!child.propagate()){
+            continue;
+          }
+          const int cell = child.next_cell(parent.cell);
+          if(cell == solver_type::FULL){
+            result = child;
+            return false;
+          }
+          tasks.push_back(task(child, cell, child.candidates(cell)));
+        }
+        tasks.pop_front();
+      }
+    }
+    return true;
+  }
+
+  void worker_loop(){
+    for(;;){
+      std::unique_lock<std::mutex> lock(mutex);
+      ++waiting;
+      wake.wait(lock, [this]{ return this->stop || !tasks.empty() || busy == 0; });
+      --waiting;
+      if(this->stop || tasks.empty()){
+        // solved elsewhere, or nobody is left to split off more work
+        wake.notify_all();
+        return;
+      }
+      task work = tasks.back();
+      tasks.pop_back();
+      --pending;
+      ++busy;
+      lock.unlock();
+
+      work.state.set_hooks(this);
+      sudoku::search_stats stats;
+      const sudoku::solve_result outcome = work.state.branch(work.cell, work.cands, limits, &stats);
+
+      lock.lock();
+      --busy;
+      if(outcome == sudoku::SOLVE_SOLVED && !found){
+        found = true;
+        result = work.state;
+        this->stop = true;
+      } else if(outcome == sudoku::SOLVE_EXHAUSTED){
+        exhausted = true;
+        this->stop = true;
+      }
+      if(this->stop || (busy == 0 && tasks.empty())){
+        wake.notify_all();
+      }
+    }
+  }
+};
+
+#endif // PARALLEL_SEARCH_H
@@ -0,0 +1,217 @@
+#ifndef RESULT_STREAM_H
+#define RESULT_STREAM_H
+
+// Binary batch results, for pipelines that would rather not format and parse text. A
+// stream is a RESULT_HEADER_SIZE-byte header followed by one fixed-size record per input
+// line, so record n starts at byte RESULT_HEADER_SIZE + n * record size. All numbers are
+// little-endian.
+//
+// header: "SDKR", format version (2 bytes), engine version (2 bytes), block size of the
+//         boards (1 byte), 0 (1 byte), record size (2 bytes), 0 (4 bytes)
+// record: status (1 byte), search nodes (8 bytes), solve time in microseconds (4 bytes),
+//         the board packed as in packed_board.h: the solution if the status is
+//         RESULT_SOLVED, the puzzle as given if it is RESULT_UNSOLVABLE or
+//         RESULT_TIMED_OUT, and all zeros if it is RESULT_MALFORMED
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+#include "../Visualizer/packed_board.h"
+#include "mapped_file.h"
+
+enum result_status { RESULT_SOLVED, RESULT_UNSOLVABLE, RESULT_TIMED_OUT, RESULT_MALFORMED };
+
+const int RESULT_HEADER_SIZE = 16;
+const int RESULT_FORMAT_VERSION = 1;
+// bumped whenever a change to the solvers changes the nodes or solutions they report
+const int RESULT_ENGINE_VERSION = 1;
+
+// one decoded record
+struct result_record{
+  result_status status;
+  long nodes;
+  long micros;
+  // the board, row-major, 0 for an empty cell
+  int cells[625];
+};
+
+
+
+// result_board_bytes(box_dim) returns the bytes of a packed board with block size
+// box_dim, or 0 if results cannot hold such boards, and result_record_size(box_dim) the
+// bytes of a whole record
+
+// time: O(1)
+inline int result_board_bytes(int box_dim){
+  switch(box_dim){
+    case 3: return sudoku::packed_board<3>::BYTES;
+    case 4: return sudoku::packed_board<4>::BYTES;
+    case 5: return sudoku::packed_board<5>::BYTES;
+    default: return 0;
+  }
+}
+
+inline int result_record_size(int box_dim){
+  return 13 + result_board_bytes(box_dim);
+}
+
+
+
+// pack_result_board<BLOCK_DIM>(cells, dst) packs the board in cells into the
+// result_board_bytes(BLOCK_DIM) bytes at dst, and unpack_result_board<BLOCK_DIM>(src, cells)
+// unpacks it back out
+template <int BLOCK_DIM>
+void pack_result_board(const int *cells, char *dst){
+  sudoku::packed_board<BLOCK_DIM> board;
+  board.pack(cells);
+  memcpy(dst, board.bytes, sizeof(board.bytes));
+}
+
+template <int BLOCK_DIM>
+void unpack_result_board(const char *src, int *cells){
+  sudoku::packed_board<BLOCK_DIM> board;
+  memcpy(board.bytes, src, sizeof(board.bytes));
+  board.unpack(cells);
+}
+
+
+
+// put_le(dst, val, bytes) writes the low bytes bytes of val to dst, lowest first, and
+// get_le(src, bytes) reads them back
+inline void put_le(char *dst, std::uint64_t val, int bytes){
+  for(int k = 0; k < bytes; ++k){
+    dst[k] = static_cast<char>(val >> (8 * k));
+  }
+}
+
+inline std::uint64_t get_le(const char *src, int bytes){
+  std::uint64_t val = 0;
+  for(int k = 0; k < bytes; ++k){
+    val |= static_cast<std::uint64_t>(static_cast<unsigned char>(src[k])) << (8 * k);
+  }
+  return val;
+}
+
+
+
+// append_result_header(box_dim, out) appends the header of a stream of boards with block
+// size box_dim to out
+
+// effects: mutates out
+
+// requires: result_board_bytes(box_dim) > 0
+inline void append_result_header(int box_dim, std::vector<char> &out){
+  char header[RESULT_HEADER_SIZE] = {'S', 'D', 'K', 'R'};
+  put_le(header + 4, RESULT_FORMAT_VERSION, 2);
+  put_le(header + 6, RESULT_ENGINE_VERSION, 2);
+  header[8] = static_cast<char>(box_dim);
+  put_le(header + 10, result_record_size(box_dim), 2);
+  out.insert(out.end(), header, header + RESULT_HEADER_SIZE);
+}
+
+
+
+// append_result(box_dim, status, nodes, micros, cells, out) appends one record to out;
+// cells may be NULL for a RESULT_MALFORMED record
+
+// effects: mutates out
+
+// requires: result_board_bytes(box_dim) > 0, cells must hold box_dim^4 numbers from 0 to
+//           box_dim^2 if it is not NULL
+inline void append_result(int box_dim, result_status status, long nodes, long micros,
+                          const int *cells, std::vector<char> &out){
+  const size_t at = out.size();
+  out.resize(at + result_record_size(box_dim));
+  char *dst = &out[at];
+  dst[0] = static_cast<char>(status);
+  put_le(dst + 1, static_cast<std::uint64_t>(nodes), 8);
+  put_le(dst + 9, micros < 0xffffffffL ? micros : 0xffffffffL, 4);
+  if(!cells){
+    memset(dst + 13, 0, result_board_bytes(box_dim));
+  } else if(box_dim == 3){
+    pack_result_board<3>(cells, dst + 13);
+  } else if(box_dim == 4){
+    pack_result_board<4>(cells, dst + 13);
+  } else{
+    pack_result_board<5>(cells, dst + 13);
+  }
+}
+
+
+
+// result_reader reads the records of a result stream in a mapped file, each in O(1)
+class result_reader{
+  public:
+  result_reader() : box_dim(0), engine_version(0), record_size(0), count(0){}
+
+
+
+  // open(path) maps the stream at path and returns true, or returns false if it cannot
+  // be mapped or does not start with a header this build understands
+
+  // requires: path must not be NULL
+  bool open(const char *path){
+    count = 0;
+    if(!map.open(path) || map.size() < static_cast<size_t>(RESULT_HEADER_SIZE)){
+      return false;
+    }
+    const char *header = map.data();
+    if(memcmp(header, "SDKR", 4) != 0 || get_le(header + 4, 2) != RESULT_FORMAT_VERSION){
+      return false;
+    }
+    box_dim = header[8];
+    record_size = static_cast<int>(get_le(header + 10, 2));
+    if(!result_board_bytes(box_dim) || record_size != result_record_size(box_dim)){
+      return false;
+    }
+    engine_version = static_cast<int>(get_le(header + 6, 2));
+    count = (map.size() - RESULT_HEADER_SIZE) / record_size;
+    return true;
+  }
+
+  // size() returns the number of whole records in the stream
+  size_t size() const{
+    return count;
+  }
+
+  int board_box_dim() const{
+    return box_dim;
+  }
+
+  int engine() const{
+    return engine_version;
+  }
+
+
+
+  // read(k, record) decodes record k into record
+
+  // requires: k < size()
+
+  // time: O(n) where n is the number of cells
+  void read(size_t k, result_record &record) const{
+    const char *src = map.data() + RESULT_HEADER_SIZE + k * record_size;
+    record.status = static_cast<result_status>(src[0]);
+    record.nodes = static_cast<long>(get_le(src + 1, 8));
+    record.micros = static_cast<long>(get_le(src + 9, 4));
+    if(box_dim == 3){
+      unpack_result_board<3>(src + 13, record.cells);
+    } else if(box_dim == 4){
+      unpack_result_board<4>(src + 13, record.cells);
+    } else{
+      unpack_result_board<5>(src + 13, record.cells);
+    }
+  }
+
+
+
+  private:
+  mapped_file map;
+  int box_dim;
+  int engine_version;
+  int record_size;
+  size_t count;
+};
+
+#endif // RESULT_STREAM_H
@@ -0,0 +1,529 @@
+// Benchmark of the solver engines over the puzzle sets in benchmark/data. Every engine
+// that handles a set's board size solves every puzzle of the set, and the 9x9 sets are
+// also solved as a batch (as -b does, on the lane solver); each solution is checked, and
+// the throughput and latency of every (set, engine) pair are written to stdout as JSON
+// or CSV so that runs can be compared between releases.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../Visualizer/backtracking_solver.h"
+#include "../Visualizer/dlx.h"
+#include "../Visualizer/matrix.h"
+#include "../Visualizer/solver.h"
+#include "../Visualizer/step_solver.h"
+#include "../backtracking_algorithm/batch.h"
+#include "../backtracking_algorithm/parallel_search.h"
+
+// one way of solving a board: solve(cells, options, stats) solves the box_dim board in
+// cells in place within the budget of options, returning like solver::solve(options,
+// stats). Engines that count their search fill in stats
+struct engine{
+  const char *name;
+  int box_dim;
+  sudoku::solve_result (*solve)(int *cells, const sudoku::solve_options &options,
+                                sudoku::search_stats *stats);
+  bool counts;
+};
+
+// a puzzle set: the file benchmark/data/<name>.txt, one puzzle per line
+struct puzzle_set{
+  const char *name;
+  int box_dim;
+};
+
+// what one engine did on one set
+struct result{
+  const char *set;
+  const char *engine;
+  long puzzles;
+  long solved;
+  // false if the time budget ran out before the end of the set
+  bool complete;
+  // false if the engine does not count nodes and guesses
+  bool counted;
+  long nodes;
+  long guesses;
+  double seconds;
+  std::vector<double> latencies;
+};
+
+
+
+// to_grid(cells, grid) and from_grid(grid, cells) convert between row-major 9x9 cells
+// and the int[][10] grids of backtracking_solver.h and matrix.h
+void to_grid(const int *cells, int grid[][10]){
+  for(int cell = 0; cell < 81; ++cell){
+    grid[cell / 9][cell % 9] = cells[cell];
+  }
+}
+
+void from_grid(int grid[][10], int *cells){
+  for(int cell = 0; cell < 81; ++cell){
+    cells[cell] = grid[cell / 9][cell % 9];
+  }
+}
+
+
+
+sudoku::solve_result solve_sudoku_solver(int *cells, const sudoku::solve_options &options,
+                                         sudoku::search_stats *stats){
+  int grid[10][10];
+  to_grid(cells, grid);
+  const sudoku::solve_result result = sudoku_solver(grid, options, stats);
+  from_grid(grid, cells);
+  return result;
+}
+
+sudoku::solve_result solve_sudoku_solver_dlx(int *cells, const sudoku::solve_options &options,
+                                             sudoku::search_stats *stats){
+  int grid[10][10];
+  to_grid(cells, grid);
+  const sudoku::solve_result result = sudoku_solver(grid, ENGINE_DLX, options, stats);
+  from_grid(grid, cells);
+  return result;
+}
+
+// solve_race(cells) races the engines of PORTFOLIO on one thread each, after a head
+// start for the first
+sudoku::solve_result solve_race(int *cells, const sudoku::solve_options &options,
+                                sudoku::search_stats *stats){
+  int grid[10][10];
+  to_grid(cells, grid);
+  const sudoku::solve_result result = sudoku_solver_race(grid, PORTFOLIO, PORTFOLIO_SIZE,
+                                                         PORTFOLIO_NODES, options, stats, NULL);
+  from_grid(grid, cells);
+  return result;
+}
+
+// solve_switching(cells) runs the engines of PORTFOLIO in turn on doubling node budgets
+sudoku::solve_result solve_switching(int *cells, const sudoku::solve_options &options,
+                                     sudoku::search_stats *stats){
+  int grid[10][10];
+  to_grid(cells, grid);
+  const sudoku::solve_result result = sudoku_solver_switching(grid, PORTFOLIO, PORTFOLIO_SIZE,
+                                                              PORTFOLIO_NODES, options, stats,
+                                                              NULL);
+  from_grid(grid, cells);
+  return result;
+}
+
+// the original is_valid() scans, kept in backtracking_solver.cpp as the reference and
+// run within a budget as ENGINE_ROW_MAJOR
+sudoku::solve_result solve_sudoku_solver_wrapper(int *cells, const sudoku::solve_options &options,
+                                                 sudoku::search_stats *stats){
+  int grid[10][10];
+  to_grid(cells, grid);
+  const sudoku::solve_result result = sudoku_solver(grid, ENGINE_ROW_MAJOR, options, stats);
+  from_grid(grid, cells);
+  return result;
+}
+
+sudoku::solve_result solve_matrix(int *cells, const sudoku::solve_options &options,
+                                  sudoku::search_stats *stats){
+  static sudoku::matrix board(1);
+  int grid[10][10];
+  to_grid(cells, grid);
+  board.input(grid);
+  const sudoku::solve_result result = board.solve(options, stats);
+  board.output(grid);
+  from_grid(grid, cells);
+  return result;
+}
+
+sudoku::solve_result solve_matrix_dfs(int *cells, const sudoku::solve_options &options,
+                                      sudoku::search_stats *stats){
+  static sudoku::matrix board(1);
+  int grid[10][10];
+  to_grid(cells, grid);
+  board.input(grid);
+  const sudoku::solve_result result = board.solve_dfs(options, stats);
+  board.output(grid);
+  from_grid(grid, cells);
+  return result;
+}
+
+// solve_solver<BOX_DIM, MODE>(cells) runs sudoku::solver<BOX_DIM> in selection MODE
+template <int BOX_DIM, sudoku::select_mode MODE>
+sudoku::solve_result solve_solver(int *cells, const sudoku::solve_options &options,
+                                  sudoku::search_stats *stats){
+  static sudoku::solver<BOX_DIM> board;
+  board.set_selection(MODE, sudoku::TIE_FIRST);
+  if(!board.load(cells)){
+    return sudoku::SOLVE_UNSOLVABLE;
+  }
+  const sudoku::solve_result result = board.solve(options, stats);
+  if(result == sudoku::SOLVE_SOLVED){
+    board.store(cells);
+  }
+  return result;
+}
+
+// solve_step_solver<BOX_DIM>(cells) runs the iterative sudoku::step_solver<BOX_DIM>, which
+// counts its nodes and guesses itself, options.check_interval nodes at a time
+template <int BOX_DIM>
+sudoku::solve_result solve_step_solver(int *cells, const sudoku::solve_options &options,
+                                       sudoku::search_stats *stats){
+  static sudoku::step_solver<BOX_DIM> board;
+  board.load(cells);
+  sudoku::step_status status;
+  while((status = board.step(options.check_interval)) == sudoku::STEP_RUNNING &&
+        sudoku::solve_options::clock::now() < options.deadline){}
+  stats->clear();
+  stats->nodes = board.nodes();
+  stats->guesses = board.guesses();
+  if(status == sudoku::STEP_RUNNING){
+    return sudoku::SOLVE_EXHAUSTED;
+  }
+  if(status != sudoku::STEP_SOLVED){
+    return sudoku::SOLVE_UNSOLVABLE;
+  }
+  board.board_state().store(cells);
+  return sudoku::SOLVE_SOLVED;
+}
+
+template <int BOX_DIM>
+sudoku::solve_result solve_dlx(int *cells, const sudoku::solve_options &options,
+                               sudoku::search_stats *stats){
+  static sudoku::dlx links(BOX_DIM);
+  return links.solve(cells, options, stats);
+}
+
+// solve_parallel<BOX_DIM>(cells) searches each board with parallel_search on one thread
+// per core
+template <int BOX_DIM>
+sudoku::solve_result solve_parallel(int *cells, const sudoku::solve_options &options,
+                                    sudoku::search_stats *){
+  static sudoku::solver<BOX_DIM> board;
+  static parallel_search<BOX_DIM> search(std::thread::hardware_concurrency());
+  if(!board.load(cells)){
+    return sudoku::SOLVE_UNSOLVABLE;
+  }
+  const sudoku::solve_result result = search.solve(board, options);
+  if(result == sudoku::SOLVE_SOLVED){
+    board.store(cells);
+  }
+  return result;
+}
+
+const engine ENGINES[] = {
+  {"sudoku_solver", 3, solve_sudoku_solver, true},
+  {"sudoku_solver_dlx", 3, solve_sudoku_solver_dlx, false},
+  {"sudoku_solver_wrapper", 3, solve_sudoku_solver_wrapper, true},
+  {"matrix_solve", 3, solve_matrix, true},
+  {"matrix_dfs", 3, solve_matrix_dfs, true},
+  {"solver_mrv", 3, solve_solver<3, sudoku::SELECT_MRV>, true},
+  {"solver_mrv_scan", 3, solve_solver<3, sudoku::SELECT_MRV_SCAN>, true},
+  {"solver_row_major", 3, solve_solver<3, sudoku::SELECT_ROW_MAJOR>, true},
+  {"step_solver", 3, solve_step_solver<3>, true},
+  {"race", 3, solve_race, true},
+  {"switching", 3, solve_switching, true},
+  {"parallel_search", 3, solve_parallel<3>, false},
+  {"solver_mrv", 4, solve_solver<4, sudoku::SELECT_MRV>, true},
+  {"solver_mrv_scan", 4, solve_solver<4, sudoku::SELECT_MRV_SCAN>, true},
+  {"solver_row_major", 4, solve_solver<4, sudoku::SELECT_ROW_MAJOR>, true},
+  {"step_solver", 4, solve_step_solver<4>, true},
+  {"parallel_search", 4, solve_parallel<4>, false},
+  {"dlx", 4, solve_dlx<4>, false},
+};
+
+const puzzle_set SETS[] = {
+  {"easy", 3},
+  {"17clue", 3},
+  {"hardest", 3},
+  {"16x16", 4},
+};
+
+
+
+// load_set(dir, set, puzzles) reads the puzzles of set from dir into puzzles, one
+// vector of cells each, and returns false if the file cannot be read
+
+// effects: reads input, mutates puzzles
+bool load_set(const char *dir, const puzzle_set &set, std::vector<std::vector<int> > &puzzles){
+  const std::string path = std::string(dir) + "/" + set.name + ".txt";
+  FILE *in = fopen(path.c_str(), "rb");
+  if(!in){
+    return false;
+  }
+  const int len = set.box_dim * set.box_dim * set.box_dim * set.box_dim;
+  char line[1024];
+  while(fgets(line, sizeof(line), in)){
+    std::vector<int> cells(625);
+    int n = strcspn(line, "\r\n");
+    if(n == len && parse_puzzle(line, n, cells.data()) == set.box_dim){
+      cells.resize(len);
+      puzzles.push_back(cells);
+    } else if(n){
+      fprintf(stderr, "%s: skipping malformed line\n", path.c_str());
+    }
+  }
+  fclose(in);
+  return true;
+}
+
+
+
+// is_solution<BOX_DIM>(puzzle, cells) returns true if cells is a complete, valid board
+// that keeps every clue of puzzle
+template <int BOX_DIM>
+bool is_solution(const int *puzzle, const int *cells){
+  const int len = BOX_DIM * BOX_DIM * BOX_DIM * BOX_DIM;
+  for(int cell = 0; cell < len; ++cell){
+    if(!cells[cell] || (puzzle[cell] && puzzle[cell] != cells[cell])){
+      return false;
+    }
+  }
+  static sudoku::solver<BOX_DIM> check;
+  return check.load(cells);
+}
+
+
+
+// run(set, puzzles, solver, max_seconds) solves puzzles one at a time with solver, each
+// within what is left of max_seconds, and stops at the first puzzle cut off
+result run(const puzzle_set &set, const std::vector<std::vector<int> > &puzzles,
+           const engine &solver, double max_seconds){
+  result res;
+  res.set = set.name;
+  res.engine = solver.name;
+  res.puzzles = res.solved = 0;
+  res.complete = true;
+  res.counted = solver.counts && SUDOKU_STATS;
+  res.nodes = res.guesses = 0;
+  res.seconds = 0;
+  std::vector<int> cells;
+  sudoku::search_stats stats;
+  sudoku::solve_options options;
+  for(size_t k = 0; k < puzzles.size(); ++k){
+    if(res.seconds > max_seconds){
+      res.complete = false;
+      break;
+    }
+    cells = puzzles[k];
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    options.deadline = start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::duration<double>(max_seconds - res.seconds));
+    const sudoku::solve_result result = solver.solve(cells.data(), options, &stats);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    res.seconds += seconds;
+    if(result == sudoku::SOLVE_EXHAUSTED){
+      // cut off at the deadline: its time counts, but not as a puzzle
+      res.complete = false;
+      break;
+    }
+    res.latencies.push_back(seconds);
+    res.nodes += stats.nodes;
+    res.guesses += stats.guesses;
+    ++res.puzzles;
+    if(result == sudoku::SOLVE_SOLVED &&
+       (set.box_dim == 3 ? is_solution<3>(puzzles[k].data(), cells.data())
+                          : is_solution<4>(puzzles[k].data(), cells.data()))){
+      ++res.solved;
+    }
+  }
+  std::sort(res.latencies.begin(), res.latencies.end());
+  return res;
+}
+
+
+
+// run_batch(set, puzzles, max_seconds) solves the puzzles of a 9x9 set as lines through
+// batch_solver, as -b does on one thread: they are held back LANES at a time and solved
+// together on the lane solver. The latency of each puzzle is the time taken by its whole
+// group of lines
+result run_batch(const puzzle_set &set, const std::vector<std::vector<int> > &puzzles,
+                 double max_seconds){
+  const int LANES = batch_solver::LANES;
+  result res;
+  res.set = set.name;
+  res.engine = "batch";
+  res.puzzles = res.solved = 0;
+  res.complete = true;
+  res.counted = false;
+  res.nodes = res.guesses = 0;
+  res.seconds = 0;
+  std::vector<char> lines(puzzles.size() * 81);
+  for(size_t k = 0; k < puzzles.size(); ++k){
+    format_puzzle(puzzles[k].data(), 3, &lines[k * 81]);
+  }
+  static batch_solver solver;
+  batch_stats stats;
+  memset(&stats, 0, sizeof(stats));
+  std::vector<char> out;
+  int cells[81];
+  for(size_t first = 0; first < puzzles.size(); first += LANES){
+    if(res.seconds > max_seconds){
+      res.complete = false;
+      break;
+    }
+    const size_t count = std::min(puzzles.size() - first, static_cast<size_t>(LANES));
+    out.clear();
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(size_t k = first; k < first + count; ++k){
+      solver.solve_line(&lines[k * 81], 81, out, stats);
+    }
+    solver.flush(out, stats);
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    res.seconds += seconds;
+    for(size_t k = 0; k < count; ++k){
+      res.latencies.push_back(seconds);
+      ++res.puzzles;
+      if(parse_puzzle(&out[k * 82], 81, cells) == 3 && is_solution<3>(puzzles[first + k].data(), cells)){
+        ++res.solved;
+      }
+    }
+  }
+  std::sort(res.latencies.begin(), res.latencies.end());
+  return res;
+}
+
+
+
+// percentile(sorted, p) returns the nearest-rank p-th percentile of sorted, in
+// microseconds
+double percentile(const std::vector<double> &sorted, double p){
+  if(sorted.empty()){
+    return 0;
+  }
+  size_t rank = static_cast<size_t>(p / 100 * sorted.size() + 0.999999);
+  rank = rank < 1 ? 1 : rank > sorted.size() ? sorted.size() : rank;
+  return sorted[rank - 1] * 1e6;
+}
+
+
+
+// print_json(results) and print_csv(results) write the results to stdout. Guesses and
+// nodes are null (empty in CSV) for engines that do not count them
+
+// effects: produces output
+void print_json(const std::vector<result> &results){
+  printf("{\"results\": [\n");
+  for(size_t k = 0; k < results.size(); ++k){
+    const result &res = results[k];
+    char guesses[32] = "null";
+    char nodes[32] = "null";
+    if(res.counted && res.puzzles){
+      snprintf(guesses, sizeof(guesses), "%.1f", static_cast<double>(res.guesses) / res.puzzles);
+      snprintf(nodes, sizeof(nodes), "%.0f", res.seconds > 0 ? res.nodes / res.seconds : 0.0);
+    }
+    printf("  {\"set\": \"%s\", \"engine\": \"%s\", \"puzzles\": %ld, \"solved\": %ld, "
+           "\"complete\": %s, \"seconds\": %.6f, \"puzzles_per_sec\": %.1f, "
+           "\"median_us\": %.2f, \"p99_us\": %.2f, \"p999_us\": %.2f, \"guesses_per_puzzle\": %s, "
+           "\"nodes_per_sec\": %s}%s\n",
+           res.set, res.engine, res.puzzles, res.solved, res.complete ? "true" : "false",
+           res.seconds, res.seconds > 0 ? res.puzzles / res.seconds : 0.0,
+           percentile(res.latencies, 50), percentile(res.latencies, 99),
+           percentile(res.latencies, 99.9), guesses, nodes,
+           k + 1 < results.size() ? "," : "");
+  }
+  printf("]}\n");
+}
+
+void print_csv(const std::vector<result> &results){
+  printf("set,engine,puzzles,solved,complete,seconds,puzzles_per_sec,median_us,p99_us,"
+         "p999_us,guesses_per_puzzle,nodes_per_sec\n");
+  for(size_t k = 0; k < results.size(); ++k){
+    const result &res = results[k];
+    printf("%s,%s,%ld,%ld,%d,%.6f,%.1f,%.2f,%.2f,%.2f,",
+           res.set, res.engine, res.puzzles, res.solved, res.complete ? 1 : 0, res.seconds,
+           res.seconds > 0 ? res.puzzles / res.seconds : 0.0,
+           percentile(res.latencies, 50), percentile(res.latencies, 99),
+           percentile(res.latencies, 99.9));
+    if(res.counted && res.puzzles){
+      printf("%.1f,%.0f\n", static_cast<double>(res.guesses) / res.puzzles,
+             res.seconds > 0 ? res.nodes / res.seconds : 0.0);
+    } else{
+      printf(",\n");
+    }
+  }
+}
+
+
+
+// print_progress(res) reports a finished (set, engine) pair on stderr
+
+// effects: produces output
+void print_progress(const result &res){
+  fprintf(stderr, "%-8s %-22s %5ld/%-5ld solved in %8.3f s%s\n", res.set, res.engine,
+          res.solved, res.puzzles, res.seconds, res.complete ? "" : " (time budget spent)");
+}
+
+
+
+void print_usage(const char *name){
+  fprintf(stderr,
+          "usage: %s [-f json|csv] [-m seconds] [-d dir] [-e engine] [-s set]\n"
+          "  runs every engine (or only -e engine) on every puzzle set (or only -s set) in\n"
+          "  dir (default benchmark/data), giving up on a set after -m seconds (default 10)\n",
+          name);
+}
+
+
+
+int main(int argc, char **argv){
+  bool csv = false;
+  double max_seconds = 10;
+  const char *dir = "benchmark/data";
+  const char *only_engine = NULL;
+  const char *only_set = NULL;
+  for(int k = 1; k < argc; ++k){
+    if(strcmp(argv[k], "-f") == 0 && k + 1 < argc){
+      ++k;
+      if(strcmp(argv[k], "csv") == 0 || strcmp(argv[k], "json") == 0){
+        csv = strcmp(argv[k], "csv") == 0;
+        continue;
+      }
+    } else if(strcmp(argv[k], "-m") == 0 && k + 1 < argc){
+      max_seconds = atof(argv[++k]);
+      continue;
+    } else if(strcmp(argv[k], "-d") == 0 && k + 1 < argc){
+      dir = argv[++k];
+      continue;
+    } else if(strcmp(argv[k], "-e") == 0 && k + 1 < argc){
+      only_engine = argv[++k];
+      continue;
+    } else if(strcmp(argv[k], "-s") == 0 && k + 1 < argc){
+      only_set = argv[++k];
+      continue;
+    }
+    print_usage(argv[0]);
+    return 2;
+  }
+
+  std::vector<result> results;
+  for(size_t s = 0; s < sizeof(SETS) / sizeof(SETS[0]); ++s){
+    const puzzle_set &set = SETS[s];
+    if(only_set && strcmp(only_set, set.name) != 0){
+      continue;
+    }
+    std::vector<std::vector<int> > puzzles;
+    if(!load_set(dir, set, puzzles)){
+      fprintf(stderr, "cannot open %s/%s.txt\n", dir, set.name);
+      return 1;
+    }
+    for(size_t e = 0; e < sizeof(ENGINES) / sizeof(ENGINES[0]); ++e){
+      const engine &solver = ENGINES[e];
+      if(solver.box_dim != set.box_dim || (only_engine && strcmp(only_engine, solver.name) != 0)){
+        continue;
+      }
+      results.push_back(run(set, puzzles, solver, max_seconds));
+      print_progress(results.back());
+    }
+    if(set.box_dim == 3 && (!only_engine || strcmp(only_engine, "batch") == 0)){
+      results.push_back(run_batch(set, puzzles, max_seconds));
+      print_progress(results.back());
+    }
+  }
+  if(csv){
+    print_csv(results);
+  } else{
+    print_json(results);
+  }
+  return 0;
+}
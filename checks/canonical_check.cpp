@@ -0,0 +1,174 @@
+// Check of canonical forms (Visualizer/canonical.h), the solution cache and batch
+// deduplication (backtracking_algorithm/dedupe.h). Every 9x9 puzzle of the bundled sets
+// is put through random relabellings, band, row, stack and column reorderings and
+// transpositions. Each transformed board must have the canonical form of the puzzle, be
+// answered by the solution cache from the puzzle's cached solution with a solution of the
+// transformed board, and be dropped by dedupe_batch() as a duplicate of the puzzle.
+
+#include <algorithm>
+#include <random>
+#include "../Visualizer/canonical.h"
+#include "../backtracking_algorithm/dedupe.h"
+#include "check.h"
+
+// the transformed boards tried per puzzle
+const int TRIALS = 8;
+
+// shuffled_order(random, order) sets order to a random reordering of the 9 rows (or
+// columns) that keeps the bands (or stacks) together: the bands in a random order, and
+// the rows of each band in a random order
+void shuffled_order(std::mt19937 &random, int *order){
+  int bands[3] = {0, 1, 2};
+  std::shuffle(bands, bands + 3, random);
+  for(int b = 0; b < 3; ++b){
+    int within[3] = {0, 1, 2};
+    std::shuffle(within, within + 3, random);
+    for(int k = 0; k < 3; ++k){
+      order[b * 3 + k] = bands[b] * 3 + within[k];
+    }
+  }
+}
+
+// transform(board, random, out) writes to out the 9x9 board turned by a random
+// relabelling, a random row and column order and, half the time, a transposition
+
+// requires: board and out must hold 81 values each and must not overlap
+void transform(const int *board, std::mt19937 &random, int *out){
+  int labels[10] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+  std::shuffle(labels + 1, labels + 10, random);
+  int rows[9], cols[9];
+  shuffled_order(random, rows);
+  shuffled_order(random, cols);
+  const bool transposed = random() & 1;
+  for(int k = 0; k < 9; ++k){
+    for(int j = 0; j < 9; ++j){
+      out[transposed ? j * 9 + k : k * 9 + j] = labels[board[rows[k] * 9 + cols[j]]];
+    }
+  }
+}
+
+// is_solution(puzzle, cells) returns true if cells is a complete, valid board that keeps
+// every clue of puzzle
+bool is_solution(const int *puzzle, const int *cells){
+  for(int cell = 0; cell < 81; ++cell){
+    if(!cells[cell] || (puzzle[cell] && puzzle[cell] != cells[cell])){
+      return false;
+    }
+  }
+  static sudoku::solver<3> board;
+  return board.load(cells);
+}
+
+
+
+// check_forms(name, puzzle, random, canon, cache, lines) checks the canonical forms and
+// cached solutions of TRIALS transformed boards of puzzle, and appends their lines to
+// lines
+
+// effects: mutates cache and lines, produces output
+void check_forms(const char *name, const std::vector<int> &puzzle, std::mt19937 &random,
+                 sudoku::canonicalizer &canon, sudoku::solution_cache &cache,
+                 std::vector<std::vector<int> > &lines){
+  sudoku::canonical_form form;
+  const bool has_form = canon.canonicalize(puzzle.data(), form);
+  int solved[81];
+  std::copy(puzzle.begin(), puzzle.end(), solved);
+  check(cache.solve(solved) && is_solution(puzzle.data(), solved), "%s: not solved by the cache",
+        name);
+  if(has_form){
+    // to_canonical() and from_canonical() undo each other
+    int there[81], back[81];
+    form.to_canonical(solved, there);
+    form.from_canonical(there, back);
+    check(std::equal(back, back + 81, solved), "%s: from_canonical() does not undo to_canonical()",
+          name);
+  }
+  for(int trial = 0; trial < TRIALS; ++trial){
+    std::vector<int> turned(81);
+    transform(puzzle.data(), random, turned.data());
+    lines.push_back(turned);
+    sudoku::canonical_form other;
+    const bool has_other = canon.canonicalize(turned.data(), other);
+    check(has_other == has_form, "%s: trial %d %s a canonical form", name, trial + 1,
+          has_form ? "has no" : "has");
+    if(!has_form || !has_other){
+      continue;
+    }
+    check(std::equal(form.cells, form.cells + 81, other.cells) && form.key() == other.key(),
+          "%s: trial %d has another canonical form", name, trial + 1);
+    const long hits = cache.hits;
+    int cells[81];
+    std::copy(turned.begin(), turned.end(), cells);
+    check(cache.solve(cells) && is_solution(turned.data(), cells),
+          "%s: trial %d not solved by the cache", name, trial + 1);
+    check(cache.hits == hits + 1, "%s: trial %d missed the cache", name, trial + 1);
+  }
+}
+
+
+
+// check_dedupe(lines, canon) runs dedupe_batch() on lines and checks that it keeps
+// exactly the lines whose canonical form was not met before (and those with none)
+
+// effects: writes scratch files, produces output
+void check_dedupe(const std::vector<std::vector<int> > &lines, sudoku::canonicalizer &canon){
+  std::string text, expected;
+  std::unordered_set<sudoku::packed_board<3>, sudoku::packed_board<3>::hasher> seen;
+  char line[82];
+  line[81] = '\n';
+  for(size_t k = 0; k < lines.size(); ++k){
+    format_puzzle(lines[k].data(), 3, line);
+    text.append(line, 82);
+    sudoku::canonical_form form;
+    if(!canon.canonicalize(lines[k].data(), form) || seen.insert(form.key()).second){
+      expected.append(line, 82);
+    }
+  }
+  const std::string in_path = temp_path("canonical_check_in");
+  const std::string out_path = temp_path("canonical_check_out");
+  write_file(in_path.c_str(), text.data(), text.size());
+  FILE *in = fopen(in_path.c_str(), "rb");
+  FILE *out = fopen(out_path.c_str(), "wb");
+  if(!check(in && out, "cannot open the dedupe scratch files")){
+    return;
+  }
+  dedupe_stats stats;
+  dedupe_batch(in, out, 2, &stats);
+  fclose(in);
+  fclose(out);
+  mapped_file kept;
+  check(kept.open(out_path.c_str()) && kept.size() == expected.size() &&
+        (!kept.size() || memcmp(kept.data(), expected.data(), kept.size()) == 0),
+        "dedupe kept %ld of %zu lines, expected %zu", stats.distinct, lines.size(),
+        expected.size() / 82);
+  remove(in_path.c_str());
+  remove(out_path.c_str());
+}
+
+
+
+int main(int argc, char **argv){
+  const char *dir = argc > 1 ? argv[1] : "benchmark/data";
+  const char *sets[] = {"easy", "17clue", "hardest"};
+  std::vector<std::vector<int> > puzzles;
+  for(int s = 0; s < 3; ++s){
+    if(!load_puzzles(dir, sets[s], 3, puzzles)){
+      fprintf(stderr, "cannot read %s/%s.txt\n", dir, sets[s]);
+      return 1;
+    }
+  }
+  std::mt19937 random(1);
+  sudoku::canonicalizer *canon = new sudoku::canonicalizer();
+  sudoku::solution_cache *cache = new sudoku::solution_cache(puzzles.size() * (TRIALS + 1));
+  // the puzzles first, then every transformed board: dedupe must keep only the puzzles
+  std::vector<std::vector<int> > lines(puzzles);
+  char name[64];
+  for(size_t k = 0; k < puzzles.size(); ++k){
+    snprintf(name, sizeof(name), "puzzle %zu", k + 1);
+    check_forms(name, puzzles[k], random, *canon, *cache, lines);
+  }
+  check_dedupe(lines, *canon);
+  delete cache;
+  delete canon;
+  return check_status("canonical_check");
+}
@@ -0,0 +1,108 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+// Helpers shared by the check programs in this folder. A check program runs from the top
+// folder, reports every failed check on stderr and exits with status 1 if any failed.
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../backtracking_algorithm/batch.h"
+
+// the number of checks run and failed so far
+struct check_totals{
+  long run;
+  long failed;
+};
+
+// check_counts() returns the totals of this program
+inline check_totals &check_counts(){
+  static check_totals totals = {0, 0};
+  return totals;
+}
+
+
+
+// check(ok, format, ...) counts one check, and if ok is false reports it on stderr with
+// the printf-style message format. Returns ok
+
+// effects: produces output
+inline bool check(bool ok, const char *format, ...){
+  ++check_counts().run;
+  if(!ok){
+    ++check_counts().failed;
+    va_list args;
+    va_start(args, format);
+    fprintf(stderr, "FAILED: ");
+    vfprintf(stderr, format, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+  }
+  return ok;
+}
+
+// check_status(name) reports how many checks ran and failed, and returns the process
+// exit status
+
+// effects: produces output
+inline int check_status(const char *name){
+  const check_totals &totals = check_counts();
+  fprintf(stderr, "%s: %ld checks, %ld failed\n", name, totals.run, totals.failed);
+  return totals.failed ? 1 : 0;
+}
+
+
+
+// load_puzzles(dir, name, box_dim, puzzles) appends the box_dim puzzles of the file
+// dir/name.txt, one per line, to puzzles as row-major cells, and returns false if the
+// file cannot be read
+
+// effects: reads input, mutates puzzles
+inline bool load_puzzles(const char *dir, const char *name, int box_dim,
+                         std::vector<std::vector<int> > &puzzles){
+  const std::string path = std::string(dir) + "/" + name + ".txt";
+  FILE *in = fopen(path.c_str(), "rb");
+  if(!in){
+    return false;
+  }
+  const int len = box_dim * box_dim * box_dim * box_dim;
+  char line[1024];
+  while(fgets(line, sizeof(line), in)){
+    std::vector<int> cells(625);
+    const int n = strcspn(line, "\r\n");
+    if(n == len && parse_puzzle(line, n, cells.data()) == box_dim){
+      cells.resize(len);
+      puzzles.push_back(cells);
+    }
+  }
+  fclose(in);
+  return true;
+}
+
+
+
+// temp_path(name) returns a path for a scratch file of the check called name
+
+// effects: may read the environment
+inline std::string temp_path(const char *name){
+  const char *dir = getenv("TMPDIR");
+  return std::string(dir && *dir ? dir : "/tmp") + "/sudoku-" + name + ".tmp";
+}
+
+// write_file(path, data, size) replaces the file at path with the size bytes of data,
+// and returns false if it cannot
+
+// effects: writes the file at path
+inline bool write_file(const char *path, const void *data, size_t size){
+  FILE *file = fopen(path, "wb");
+  if(!file){
+    return false;
+  }
+  const bool ok = !size || fwrite(data, 1, size, file) == size;
+  return fclose(file) == 0 && ok;
+}
+
+#endif // CHECK_H
@@ -0,0 +1,104 @@
+// Check of the lane propagation kernels (Visualizer/lane_solver.h). propagate_lanes()
+// only ever runs the kernel picked for the CPU it is on, so this fills LANES boards from
+// the easy, 17-clue and hardest 9x9 sets, knocks random candidates out of some of them
+// so that a share of the lanes dies, and checks that propagate_lanes_avx2() and
+// propagate_lanes_avx512() leave the same masks and return the same dead lanes as
+// propagate_lanes_generic(). Kernels the CPU lacks are skipped.
+
+#include <cstdint>
+#include <random>
+#include "../Visualizer/lane_solver.h"
+#include "check.h"
+
+using sudoku::simd::LANES;
+
+// the groups of LANES boards propagated
+const int GROUPS = 20000;
+// the cells of a 9x9 board
+const int CELLS = 81;
+
+// a kernel to check against propagate_lanes_generic()
+struct named_kernel{
+  const char *name;
+  std::uint32_t (*kernel)(std::uint16_t *);
+  bool supported;
+};
+
+// fill_lanes(puzzles, masks, random) lays random puzzles into the lanes of masks, as
+// lane_solver::solve() does, and knocks random candidates out of about half the lanes
+
+// effects: mutates masks
+void fill_lanes(const std::vector<std::vector<int> > &puzzles, std::uint16_t *masks,
+                std::mt19937 &random){
+  std::uniform_int_distribution<size_t> pick(0, puzzles.size() - 1);
+  std::uniform_int_distribution<int> cell_of(0, CELLS - 1), bit_of(0, 8), knocks(0, 12);
+  for(int k = 0; k < LANES; ++k){
+    const std::vector<int> &puzzle = puzzles[pick(random)];
+    for(int cell = 0; cell < CELLS; ++cell){
+      const int val = puzzle[cell];
+      masks[cell * LANES + k] = val == 0 ? 0x1ff : 1 << (val - 1);
+    }
+    if(random() & 1){
+      for(int n = knocks(random); n > 0; --n){
+        masks[cell_of(random) * LANES + k] &= ~(1 << bit_of(random));
+      }
+    }
+  }
+}
+
+
+
+int main(int argc, char **argv){
+  const char *dir = argc > 1 ? argv[1] : "benchmark/data";
+  const char *sets[] = {"easy", "17clue", "hardest"};
+  std::vector<std::vector<int> > puzzles;
+  for(int s = 0; s < 3; ++s){
+    if(!load_puzzles(dir, sets[s], 3, puzzles)){
+      fprintf(stderr, "cannot read %s/%s.txt\n", dir, sets[s]);
+      return 1;
+    }
+  }
+#ifdef SIMD_SCAN_X86
+  const named_kernel kernels[] = {
+    {"propagate_lanes_avx2", sudoku::simd::propagate_lanes_avx2,
+     __builtin_cpu_supports("avx2") != 0},
+    {"propagate_lanes_avx512", sudoku::simd::propagate_lanes_avx512,
+     __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw") &&
+     __builtin_cpu_supports("avx512vl")},
+  };
+  const int count = sizeof(kernels) / sizeof(kernels[0]);
+  for(int k = 0; k < count; ++k){
+    if(!kernels[k].supported){
+      fprintf(stderr, "%s: not supported by this CPU, skipped\n", kernels[k].name);
+    }
+  }
+  std::mt19937 random(1);
+  std::uint16_t start[CELLS * LANES], masks[CELLS * LANES], other_masks[CELLS * LANES];
+  long lanes_dead = 0;
+  for(int group = 0; group < GROUPS; ++group){
+    fill_lanes(puzzles, start, random);
+    memcpy(masks, start, sizeof(masks));
+    const std::uint32_t dead = sudoku::simd::propagate_lanes_generic(masks);
+    lanes_dead += __builtin_popcount(dead);
+    for(int k = 0; k < count; ++k){
+      if(!kernels[k].supported){
+        continue;
+      }
+      memcpy(other_masks, start, sizeof(other_masks));
+      const std::uint32_t other_dead = kernels[k].kernel(other_masks);
+      check(other_dead == dead, "group %d: %s finds dead lanes %04x, the generic kernel %04x",
+            group + 1, kernels[k].name, other_dead, dead);
+      check(memcmp(other_masks, masks, sizeof(masks)) == 0,
+            "group %d: %s leaves different masks from the generic kernel",
+            group + 1, kernels[k].name);
+    }
+  }
+  // both dead and live lanes must have been compared
+  const long lanes = static_cast<long>(GROUPS) * LANES;
+  check(lanes_dead > lanes / 20 && lanes_dead < lanes - lanes / 20,
+        "%ld of %ld lanes died", lanes_dead, lanes);
+#else
+  fprintf(stderr, "no vector lane kernels on this architecture, nothing to check\n");
+#endif
+  return check_status("lane_check");
+}
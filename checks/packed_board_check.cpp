@@ -0,0 +1,129 @@
+// Check of the packed boards (Visualizer/packed_board.h). Random boards of every block
+// size from 3 to 6, from empty to full, must come back unchanged from pack() and
+// pack_grid(), read() must agree with unpack() and write() must change only its own
+// cell. The puzzle sets are then held in packed_boards containers, which must keep
+// them back to back and give every one back as it went in.
+
+#include <cstdint>
+#include <random>
+#include "../Visualizer/packed_board.h"
+#include "check.h"
+
+// the random boards packed per block size
+const int TRIALS = 2000;
+
+// check_board<BOX_DIM>(random) packs TRIALS random boards of BOX_DIM and checks them
+
+// effects: produces output
+template <int BOX_DIM>
+void check_board(std::mt19937 &random){
+  typedef sudoku::packed_board<BOX_DIM> board_type;
+  const int SIDE = board_type::SIDE;
+  const int CELLS = board_type::CELLS;
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::uniform_int_distribution<int> number(1, SIDE), cell_of(0, CELLS - 1);
+  std::vector<int> cells(CELLS), back(CELLS);
+  std::vector<int> grid((SIDE + 1) * (SIDE + 1));
+  int (*rows)[SIDE + 1] = reinterpret_cast<int (*)[SIDE + 1]>(grid.data());
+  for(int trial = 0; trial < TRIALS; ++trial){
+    const double filled = trial == 0 ? 0 : trial == 1 ? 1 : uniform(random);
+    for(int cell = 0; cell < CELLS; ++cell){
+      cells[cell] = uniform(random) < filled ? number(random) : 0;
+    }
+    board_type board;
+    board.pack(cells.data());
+    board.unpack(back.data());
+    check(back == cells, "%dx%d board %d: unpack() differs from the board packed",
+          SIDE, SIDE, trial + 1);
+    bool same = true;
+    for(int cell = 0; cell < CELLS; ++cell){
+      same = same && board.read(cell) == cells[cell];
+    }
+    check(same, "%dx%d board %d: read() differs from the board packed", SIDE, SIDE, trial + 1);
+
+    for(int cell = 0; cell < CELLS; ++cell){
+      rows[cell / SIDE][cell % SIDE] = cells[cell];
+    }
+    board_type from_grid;
+    from_grid.pack_grid(rows);
+    check(from_grid == board, "%dx%d board %d: pack_grid() differs from pack()",
+          SIDE, SIDE, trial + 1);
+    std::fill(grid.begin(), grid.end(), 0);
+    from_grid.unpack_grid(rows);
+    same = true;
+    for(int cell = 0; cell < CELLS; ++cell){
+      same = same && rows[cell / SIDE][cell % SIDE] == cells[cell];
+    }
+    check(same, "%dx%d board %d: unpack_grid() differs from the board packed",
+          SIDE, SIDE, trial + 1);
+
+    const int cell = cell_of(random);
+    const int val = trial % 2 ? SIDE : number(random) % (SIDE + 1);
+    board_type written = board;
+    written.write(cell, val);
+    written.unpack(back.data());
+    std::vector<int> expected(cells);
+    expected[cell] = val;
+    check(back == expected, "%dx%d board %d: write(%d, %d) changes other cells",
+          SIDE, SIDE, trial + 1, cell, val);
+    check((written == board) == (val == cells[cell]) &&
+          (val != cells[cell] || typename board_type::hasher()(written) ==
+                                 typename board_type::hasher()(board)),
+          "%dx%d board %d: == or the hash disagrees after write(%d, %d)",
+          SIDE, SIDE, trial + 1, cell, val);
+  }
+}
+
+
+
+// check_boards(name, box_dim, puzzles) holds puzzles in a packed_boards container and
+// checks it gives them all back
+
+// effects: produces output
+template <int BOX_DIM>
+void check_boards(const char *name, const std::vector<std::vector<int> > &puzzles){
+  typedef sudoku::packed_board<BOX_DIM> board_type;
+  sudoku::packed_boards<BOX_DIM> boards;
+  boards.reserve(puzzles.size());
+  for(size_t k = 0; k < puzzles.size(); ++k){
+    if(k % 2){
+      boards.push_back(puzzles[k].data());
+    } else{
+      board_type board;
+      board.pack(puzzles[k].data());
+      boards.push_back(board);
+    }
+  }
+  check(boards.size() == puzzles.size() &&
+        boards.bytes() == puzzles.size() * board_type::BYTES,
+        "%s: %zu boards held in %zu bytes", name, boards.size(), boards.bytes());
+  std::vector<int> cells(board_type::CELLS);
+  for(size_t k = 0; k < boards.size() && k < puzzles.size(); ++k){
+    boards.unpack(k, cells.data());
+    check(cells == puzzles[k], "%s: puzzle %zu comes back changed", name, k + 1);
+    check(reinterpret_cast<const std::uint8_t *>(boards.data()) + k * board_type::BYTES ==
+          boards[k].bytes, "%s: puzzle %zu is not where data() puts it", name, k + 1);
+  }
+  boards.pop_back();
+  check(boards.size() + 1 == puzzles.size(), "%s: pop_back() leaves %zu boards",
+        name, boards.size());
+}
+
+
+
+int main(int argc, char **argv){
+  const char *dir = argc > 1 ? argv[1] : "benchmark/data";
+  std::vector<std::vector<int> > hardest, large;
+  if(!load_puzzles(dir, "hardest", 3, hardest) || !load_puzzles(dir, "16x16", 4, large)){
+    fprintf(stderr, "cannot read the puzzle sets in %s\n", dir);
+    return 1;
+  }
+  std::mt19937 random(1);
+  check_board<3>(random);
+  check_board<4>(random);
+  check_board<5>(random);
+  check_board<6>(random);
+  check_boards<3>("hardest", hardest);
+  check_boards<4>("16x16", large);
+  return check_status("packed_board_check");
+}
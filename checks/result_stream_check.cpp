@@ -0,0 +1,309 @@
+// Round-trip check of binary batch results (backtracking_algorithm/result_stream.h). A
+// batch of 9x9 lines (solvable, unsolvable, over a node budget, malformed and blank) and
+// one of 16x16 lines are solved as text and written as result streams, as -b and -b -w
+// do, through both the stream reader and the mapped reader on one and on several
+// threads. Every stream is decoded as -x does and must agree with the text output line
+// for line, status for status; records read by seeking to them must match the decoded
+// ones, the streams of every path must hold the same records, and damaged streams must
+// be refused or read up to their last whole record.
+
+#include <algorithm>
+#include <random>
+#include "check.h"
+
+// the node budget of every board: the hardest boards run over it
+const long MAX_NODES = 30;
+// the records read by seeking, per stream
+const int SEEKS = 64;
+
+// read_lines(path, lines) replaces lines with the lines of the file at path, newlines
+// left out, and returns false if it cannot be read
+
+// effects: reads input, mutates lines
+bool read_lines(const char *path, std::vector<std::string> &lines){
+  lines.clear();
+  mapped_file file;
+  if(!file.open(path)){
+    return false;
+  }
+  for(size_t at = 0; at < file.size();){
+    const size_t end = line_end(file.data(), file.size(), at);
+    lines.push_back(std::string(file.data() + at, file.data() + end - (file.data()[end - 1] == '\n')));
+    at = end;
+  }
+  return true;
+}
+
+// cells_of(line, box_dim) returns the cells of a box_dim board line, or an empty vector if
+// line is not one
+std::vector<int> cells_of(const std::string &line, int box_dim){
+  std::vector<int> cells(625);
+  if(line.empty() || parse_puzzle(line.data(), static_cast<int>(line.size()), cells.data()) != box_dim){
+    return std::vector<int>();
+  }
+  cells.resize(box_dim * box_dim * box_dim * box_dim);
+  return cells;
+}
+
+// same_record(a, b, cells) returns true if the records a and b agree on everything but
+// the solve time, comparing cells board cells
+bool same_record(const result_record &a, const result_record &b, int cells){
+  return a.status == b.status && a.nodes == b.nodes && std::equal(a.cells, a.cells + cells, b.cells);
+}
+
+
+
+// check_stream(name, path, box_dim, input, text, records, random) checks the result
+// stream at path against the input lines and the text output of the same batch, and
+// sets records to its records
+
+// effects: reads and writes scratch files, mutates records, produces output
+void check_stream(const char *name, const char *path, int box_dim,
+                  const std::vector<std::string> &input, const std::vector<std::string> &text,
+                  std::vector<result_record> &records, std::mt19937 &random){
+  const int cells = box_dim * box_dim * box_dim * box_dim;
+  records.clear();
+  result_reader reader;
+  if(!check(reader.open(path), "%s: not a result stream", name)){
+    return;
+  }
+  check(reader.board_box_dim() == box_dim && reader.engine() == RESULT_ENGINE_VERSION,
+        "%s: header says block size %d, engine %d", name, reader.board_box_dim(), reader.engine());
+  if(!check(reader.size() == input.size(), "%s: %zu records for %zu lines", name, reader.size(),
+            input.size())){
+    return;
+  }
+
+  // decoded as -x does
+  const std::string decoded_path = temp_path("result_stream_check_decoded");
+  FILE *out = fopen(decoded_path.c_str(), "wb");
+  if(!check(out != NULL, "%s: cannot decode", name)){
+    return;
+  }
+  decode_results(reader, out);
+  fclose(out);
+  std::vector<std::string> decoded;
+  read_lines(decoded_path.c_str(), decoded);
+  remove(decoded_path.c_str());
+  if(!check(decoded.size() == input.size(), "%s: decoded to %zu lines", name, decoded.size())){
+    return;
+  }
+  const char *names[] = {"solved", "unsolvable", "timeout", "malformed"};
+  for(size_t k = 0; k < input.size(); ++k){
+    result_record record;
+    reader.read(k, record);
+    records.push_back(record);
+    const std::vector<int> puzzle = cells_of(input[k], box_dim);
+    const std::vector<int> board(record.cells, record.cells + cells);
+    const size_t space = decoded[k].find(' ');
+    char status[16];
+    long nodes = -1;
+    check(space != std::string::npos &&
+          sscanf(decoded[k].c_str() + space, " %15s %ld", status, &nodes) == 2 &&
+          strcmp(status, names[record.status]) == 0 && nodes == record.nodes &&
+          (record.status == RESULT_MALFORMED ? decoded[k].compare(0, space, "-") == 0 :
+                                               cells_of(decoded[k].substr(0, space), box_dim) == board),
+          "%s: line %zu decodes to \"%s\"", name, k + 1, decoded[k].c_str());
+    if(puzzle.empty()){
+      // the text output solves boards of any size, and passes the rest through
+      std::vector<int> any(625);
+      check(record.status == RESULT_MALFORMED &&
+            (parse_puzzle(input[k].data(), static_cast<int>(input[k].size()), any.data()) ||
+             text[k] == input[k]),
+            "%s: line %zu is malformed but has status %d", name, k + 1, record.status);
+    } else if(record.status == RESULT_SOLVED){
+      // the text output holds the same solution, perhaps written as numbers
+      check(cells_of(text[k], box_dim) == board && text[k] != input[k],
+            "%s: line %zu solved differently in text", name, k + 1);
+    } else{
+      check(record.status <= RESULT_MALFORMED && record.status != RESULT_MALFORMED &&
+            board == puzzle && text[k] == input[k],
+            "%s: line %zu has status %d and a board other than its puzzle", name, k + 1,
+            record.status);
+      check(record.status != RESULT_TIMED_OUT || record.nodes >= MAX_NODES,
+            "%s: line %zu timed out after only %ld nodes", name, k + 1, record.nodes);
+    }
+  }
+
+  // seeking to a record reads the same as reading them in order
+  std::uniform_int_distribution<size_t> pick(0, input.size() - 1);
+  for(int k = 0; k < SEEKS; ++k){
+    const size_t at = pick(random);
+    result_record record;
+    reader.read(at, record);
+    check(same_record(record, records[at], cells) && record.micros == records[at].micros,
+          "%s: record %zu reads differently when sought", name, at + 1);
+  }
+}
+
+
+
+// check_damage(path, box_dim) checks that damaged copies of the stream at path are
+// refused, or read up to their last whole record
+
+// effects: writes scratch files, produces output
+void check_damage(const char *path, int box_dim){
+  mapped_file stream;
+  if(!check(stream.open(path) && stream.size() > static_cast<size_t>(RESULT_HEADER_SIZE),
+            "cannot map %s", path)){
+    return;
+  }
+  const std::string damaged_path = temp_path("result_stream_check_damaged");
+  const std::vector<char> bytes(stream.data(), stream.data() + stream.size());
+  const size_t record_size = result_record_size(box_dim);
+  result_reader reader;
+
+  write_file(damaged_path.c_str(), bytes.data(), RESULT_HEADER_SIZE - 1);
+  check(!reader.open(damaged_path.c_str()), "a stream cut inside its header was opened");
+  std::vector<char> copy(bytes);
+  copy[0] = 'X';
+  write_file(damaged_path.c_str(), copy.data(), copy.size());
+  check(!reader.open(damaged_path.c_str()), "a stream with a bad magic number was opened");
+  copy = bytes;
+  copy[8] = 7;
+  write_file(damaged_path.c_str(), copy.data(), copy.size());
+  check(!reader.open(damaged_path.c_str()), "a stream of 49x49 boards was opened");
+  copy = bytes;
+  copy[10] ^= 1;
+  write_file(damaged_path.c_str(), copy.data(), copy.size());
+  check(!reader.open(damaged_path.c_str()), "a stream with the wrong record size was opened");
+
+  const size_t records = (bytes.size() - RESULT_HEADER_SIZE) / record_size;
+  const size_t cut = RESULT_HEADER_SIZE + (records / 2) * record_size + record_size / 2;
+  write_file(damaged_path.c_str(), bytes.data(), cut);
+  check(reader.open(damaged_path.c_str()) && reader.size() == records / 2,
+        "a stream cut inside record %zu reads %zu records", records / 2 + 1, reader.size());
+  remove(damaged_path.c_str());
+}
+
+
+
+// check_batch(name, input, box_dim, random) solves the lines of input as text and as
+// result streams of box_dim boards on every path, and checks the streams
+
+// effects: reads and writes scratch files, produces output
+void check_batch(const char *name, const std::vector<std::string> &input, int box_dim,
+                 std::mt19937 &random){
+  batch_limits limits;
+  limits.max_nodes = MAX_NODES;
+  limits.max_seconds = 0;
+  std::string joined;
+  for(size_t k = 0; k < input.size(); ++k){
+    joined += input[k] + "\n";
+  }
+  const std::string in_path = temp_path("result_stream_check_in");
+  const std::string out_path = temp_path("result_stream_check_out");
+  write_file(in_path.c_str(), joined.data(), joined.size());
+  batch_stats stats;
+
+  // the text output, as -b writes it
+  FILE *in = fopen(in_path.c_str(), "rb");
+  FILE *out = fopen(out_path.c_str(), "wb");
+  solve_batch(in, out, 1, limits, 0, &stats);
+  fclose(in);
+  fclose(out);
+  std::vector<std::string> text;
+  read_lines(out_path.c_str(), text);
+  if(!check(text.size() == input.size(), "%s: %zu text lines for %zu", name, text.size(),
+            input.size())){
+    return;
+  }
+
+  // the streams: read through stdio, then mapped on one and on three threads
+  std::vector<result_record> first, records;
+  mapped_file mapped;
+  check(mapped.open(in_path.c_str()), "%s: cannot map the input", name);
+  for(int path = 0; path < 3; ++path){
+    out = fopen(out_path.c_str(), "wb");
+    if(path == 0){
+      in = fopen(in_path.c_str(), "rb");
+      solve_batch(in, out, 1, limits, box_dim, &stats);
+      fclose(in);
+    } else{
+      solve_batch_mapped(mapped.data(), mapped.size(), out, path == 1 ? 1 : 3, false, limits,
+                         box_dim, &stats);
+    }
+    fclose(out);
+    char stream_name[64];
+    snprintf(stream_name, sizeof(stream_name), "%s (%s)", name,
+             path == 0 ? "stdio" : path == 1 ? "mapped, 1 thread" : "mapped, 3 threads");
+    check_stream(stream_name, out_path.c_str(), box_dim, input, text, path ? records : first,
+                 random);
+    if(path){
+      bool same = records.size() == first.size();
+      for(size_t k = 0; same && k < records.size(); ++k){
+        same = same_record(records[k], first[k], box_dim * box_dim * box_dim * box_dim);
+      }
+      check(same, "%s: holds other records than the stdio stream", stream_name);
+    }
+  }
+  check_damage(out_path.c_str(), box_dim);
+  remove(in_path.c_str());
+  remove(out_path.c_str());
+
+  // every status turns up in the 9x9 batch
+  int seen[RESULT_MALFORMED + 1] = {};
+  for(size_t k = 0; k < first.size(); ++k){
+    ++seen[first[k].status];
+  }
+  if(box_dim == 3){
+    check(seen[RESULT_SOLVED] && seen[RESULT_UNSOLVABLE] && seen[RESULT_TIMED_OUT] &&
+          seen[RESULT_MALFORMED], "%s: not every status turned up (%d %d %d %d)", name,
+          seen[RESULT_SOLVED], seen[RESULT_UNSOLVABLE], seen[RESULT_TIMED_OUT],
+          seen[RESULT_MALFORMED]);
+  }
+}
+
+
+
+// set_lines(dir, name, box_dim, lines) appends the puzzles of dir/name.txt to lines in
+// batch line format, and returns false if the file cannot be read
+
+// effects: reads input, mutates lines
+bool set_lines(const char *dir, const char *name, int box_dim, std::vector<std::string> &lines){
+  std::vector<std::vector<int> > puzzles;
+  if(!load_puzzles(dir, name, box_dim, puzzles)){
+    return false;
+  }
+  std::vector<char> line(625);
+  for(size_t k = 0; k < puzzles.size(); ++k){
+    format_puzzle(puzzles[k].data(), box_dim, line.data());
+    lines.push_back(std::string(line.data(), line.data() + puzzles[k].size()));
+  }
+  return true;
+}
+
+int main(int argc, char **argv){
+  const char *dir = argc > 1 ? argv[1] : "benchmark/data";
+  std::vector<std::string> small, large;
+  if(!set_lines(dir, "easy", 3, small)){
+    fprintf(stderr, "cannot read the puzzle sets in %s\n", dir);
+    return 1;
+  }
+  small.resize(100);
+  if(!set_lines(dir, "17clue", 3, small) || !set_lines(dir, "hardest", 3, small) ||
+     !set_lines(dir, "16x16", 4, large)){
+    fprintf(stderr, "cannot read the puzzle sets in %s\n", dir);
+    return 1;
+  }
+  // unsolvable: the last cell of the first row has no candidate left, and then two clues
+  // that clash
+  small.push_back("12345678.........9" + std::string(63, '.'));
+  small.push_back("11" + std::string(79, '.'));
+  // malformed, blank, and a board written as numbers
+  small.push_back("not a board");
+  small.push_back("");
+  std::string numbers;
+  const std::vector<int> cells = cells_of(small[0], 3);
+  for(int cell = 0; cell < 81; ++cell){
+    numbers += std::to_string(cells[cell]) + (cell < 80 ? " " : "");
+  }
+  small.push_back(numbers);
+  small.insert(small.end(), large.begin(), large.begin() + 2);
+  large.push_back(small[0]);
+
+  std::mt19937 random(1);
+  check_batch("9x9 batch", small, 3, random);
+  check_batch("16x16 batch", large, 4, random);
+  return check_status("result_stream_check");
+}
@@ -0,0 +1,116 @@
+// Check of the whole-board candidate scan kernels (Visualizer/simd_scan.h). board_scan()
+// only ever runs the kernel picked for the CPU it is on, so this runs scan_scalar(),
+// scan_sse2() and scan_avx2() side by side on random 9x9 and 16x16 masks and boards,
+// from nearly empty to full, and checks that the vector kernels agree with the scalar
+// one on every candidate mask, every row of singles, the fewest candidates and the cell
+// picked. Kernels the CPU lacks are skipped.
+
+#include <cstdint>
+#include <random>
+#include "../Visualizer/simd_scan.h"
+#include "check.h"
+
+using sudoku::simd::board_scan_input;
+using sudoku::simd::board_scan_output;
+using sudoku::simd::scan_kernel;
+
+// the random boards scanned per block size
+const int TRIALS = 50000;
+
+// a kernel to check against scan_scalar()
+struct named_kernel{
+  const char *name;
+  scan_kernel kernel;
+  bool supported;
+};
+
+// random_mask(random, all, density) returns a mask of the bits of all, each set with
+// probability density
+std::uint16_t random_mask(std::mt19937 &random, std::uint16_t all, double density){
+  std::bernoulli_distribution set(density);
+  std::uint16_t mask = 0;
+  for(int bit = 0; bit < 16; ++bit){
+    if(((all >> bit) & 1) && set(random)){
+      mask |= 1 << bit;
+    }
+  }
+  return mask;
+}
+
+
+
+// check_scans(box_dim, kernels, count, random) scans TRIALS random boards of box_dim with
+// scan_scalar() and with each supported kernel, and checks that they agree
+
+// effects: produces output
+void check_scans(int box_dim, const named_kernel *kernels, int count, std::mt19937 &random){
+  const int side = box_dim * box_dim;
+  std::uniform_real_distribution<double> uniform(0, 1);
+  std::uniform_int_distribution<int> number(1, side);
+  std::uint16_t rows[16], cols[16], boxes[16];
+  // the kernels read 16 bytes from the start of every row
+  std::uint8_t grid[256 + 16];
+  std::uint16_t cand[16 * 16], other_cand[16 * 16];
+  std::uint64_t singles[16], other_singles[16];
+  board_scan_input in = {rows, cols, boxes, grid, box_dim,
+                         static_cast<std::uint16_t>((1 << side) - 1)};
+  const board_scan_output out = {cand, singles};
+  const board_scan_output other_out = {other_cand, other_singles};
+  for(int trial = 0; trial < TRIALS; ++trial){
+    const double density = uniform(random);
+    // every tenth board is full
+    const double filled = trial % 10 == 0 ? 1 : uniform(random);
+    for(int k = 0; k < side; ++k){
+      rows[k] = random_mask(random, in.all, density);
+      cols[k] = random_mask(random, in.all, density);
+      boxes[k] = random_mask(random, in.all, density);
+    }
+    memset(grid, 0, sizeof(grid));
+    for(int cell = 0; cell < side * side; ++cell){
+      grid[cell] = uniform(random) < filled ? static_cast<std::uint8_t>(number(random)) : 0;
+    }
+    int best;
+    const int fewest = sudoku::simd::scan_scalar(in, out, best);
+    for(int k = 0; k < count; ++k){
+      if(!kernels[k].supported){
+        continue;
+      }
+      memset(other_cand, 0, sizeof(other_cand));
+      int other_best;
+      const int other_fewest = kernels[k].kernel(in, other_out, other_best);
+      bool same = other_fewest == fewest && other_best == best;
+      for(int i = 0; same && i < side; ++i){
+        same = other_singles[i] == singles[i];
+        for(int j = 0; same && j < side; ++j){
+          same = other_cand[16 * i + j] == cand[16 * i + j];
+        }
+      }
+      check(same, "%dx%d board %d: %s finds %d candidates at cell %d, scan_scalar %d at %d%s",
+            side, side, trial + 1, kernels[k].name, other_fewest, other_best, fewest, best,
+            other_fewest == fewest && other_best == best ? " (masks or singles differ)" : "");
+    }
+  }
+}
+
+
+
+int main(){
+#ifdef SIMD_SCAN_X86
+  const named_kernel kernels[] = {
+    {"scan_sse2", sudoku::simd::scan_sse2, __builtin_cpu_supports("sse2") != 0},
+    {"scan_avx2", sudoku::simd::scan_avx2, __builtin_cpu_supports("avx2") != 0},
+  };
+  const int count = sizeof(kernels) / sizeof(kernels[0]);
+  for(int k = 0; k < count; ++k){
+    if(!kernels[k].supported){
+      fprintf(stderr, "%s: not supported by this CPU, skipped\n", kernels[k].name);
+    }
+  }
+  std::mt19937 random(1);
+  check_scans(3, kernels, count, random);
+  check_scans(4, kernels, count, random);
+#else
+  fprintf(stderr, "no vector scan kernels on this architecture, nothing to check\n");
+#endif
+  return check_status("scan_check");
+}
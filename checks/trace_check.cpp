@@ -0,0 +1,155 @@
+// Round-trip check of solve traces (Visualizer/solve_trace.h). Every puzzle of the hardest
+// 9x9 set and of the 16x16 set is solved with solver::solve(trace) and the trace is saved
+// and loaded into a trace_player. The player must count the steps recorded, agree with a
+// linear replay at random seek() frames (forwards and backwards), end on the solution,
+// refuse files cut inside the header and play files cut inside the steps up to their last
+// whole step.
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <random>
+#include "../Visualizer/solve_trace.h"
+#include "../Visualizer/solver.h"
+#include "check.h"
+
+// the random seek() frames tried per trace
+const int SEEKS = 64;
+// the cuts inside the steps tried per trace
+const int CUTS = 8;
+
+// board_of(player) returns the board the player is at
+std::vector<int> board_of(const sudoku::trace_player &player){
+  std::vector<int> cells(player.board_cells());
+  for(int cell = 0; cell < player.board_cells(); ++cell){
+    cells[cell] = player.read(cell);
+  }
+  return cells;
+}
+
+
+
+// check_cuts(name, trace, path, full, random) writes the trace cut short at a few places
+// to path and checks what the player makes of each
+
+// effects: writes the file at path, produces output
+void check_cuts(const char *name, const sudoku::solve_trace &trace, const char *path,
+                sudoku::trace_player &full, std::mt19937 &random){
+  const std::vector<std::uint8_t> &bytes = trace.bytes();
+  const size_t steps_at = sudoku::solve_trace::HEADER + full.board_cells();
+  const size_t header_cuts[] = {0, 3, sudoku::solve_trace::HEADER - 1, steps_at - 1};
+  for(size_t k = 0; k < sizeof(header_cuts) / sizeof(header_cuts[0]); ++k){
+    sudoku::trace_player player;
+    write_file(path, bytes.data(), header_cuts[k]);
+    check(!player.load(path), "%s: loaded a trace cut to %zu bytes", name, header_cuts[k]);
+  }
+  if(bytes.size() <= steps_at){
+    return;
+  }
+  std::uniform_int_distribution<size_t> pick(steps_at, bytes.size() - 1);
+  for(int k = 0; k < CUTS; ++k){
+    const size_t cut = pick(random);
+    // a step ends at each byte without the varint continuation bit
+    long whole = 0;
+    for(size_t at = steps_at; at < cut; ++at){
+      whole += !(bytes[at] & 0x80);
+    }
+    sudoku::trace_player player;
+    write_file(path, bytes.data(), cut);
+    if(!check(player.load(path), "%s: cannot load the trace cut to %zu bytes", name, cut)){
+      continue;
+    }
+    check(player.frames() == whole, "%s: cut to %zu bytes plays %ld steps, not %ld", name, cut,
+          player.frames(), whole);
+    player.seek(player.frames());
+    full.seek(whole);
+    check(board_of(player) == board_of(full), "%s: cut to %zu bytes ends on another board", name,
+          cut);
+  }
+}
+
+
+
+// check_puzzle<BOX_DIM>(name, puzzle, path, random) records the solve of puzzle, plays it
+// back from path and returns the number of steps recorded
+
+// effects: writes the file at path, produces output
+template <int BOX_DIM>
+long check_puzzle(const char *name, const std::vector<int> &puzzle, const char *path,
+                  std::mt19937 &random){
+  typedef sudoku::solver<BOX_DIM> solver_type;
+  static solver_type board;
+  sudoku::solve_trace trace;
+  board.load(puzzle.data());
+  check(board.solve(&trace), "%s: not solved", name);
+  std::vector<int> solution(solver_type::CELLS);
+  board.store(solution.data());
+  sudoku::trace_player player;
+  if(!check(trace.save(path) && player.load(path), "%s: cannot save and load the trace", name)){
+    return 0;
+  }
+  check(player.box_dim() == BOX_DIM, "%s: block size %d", name, player.box_dim());
+  check(player.frames() == trace.steps(), "%s: %ld frames for %ld steps", name, player.frames(),
+        trace.steps());
+  check(board_of(player) == puzzle, "%s: does not start from the puzzle", name);
+  for(int cell = 0; cell < solver_type::CELLS; ++cell){
+    check(player.given(cell) == (puzzle[cell] != 0), "%s: cell %d given wrongly", name, cell);
+  }
+
+  // the boards of a linear replay at the frames to seek to
+  std::vector<long> frames(1, 0);
+  frames.push_back(player.frames());
+  std::uniform_int_distribution<long> pick(0, player.frames());
+  for(int k = 0; k < SEEKS; ++k){
+    frames.push_back(pick(random));
+  }
+  std::sort(frames.begin(), frames.end());
+  std::map<long, std::vector<int> > expected;
+  sudoku::trace_player linear;
+  linear.load(path);
+  int cell, val;
+  for(size_t k = 0; k < frames.size(); ++k){
+    while(linear.frame() < frames[k] && linear.next(cell, val)){}
+    expected[frames[k]] = board_of(linear);
+  }
+  check(!linear.next(cell, val), "%s: steps past frames()", name);
+
+  std::shuffle(frames.begin(), frames.end(), random);
+  for(size_t k = 0; k < frames.size(); ++k){
+    player.seek(frames[k]);
+    check(player.frame() == frames[k] && board_of(player) == expected[frames[k]],
+          "%s: seek(%ld) differs from the linear replay", name, frames[k]);
+  }
+  player.seek(player.frames());
+  check(board_of(player) == solution, "%s: does not end on the solution", name);
+
+  check_cuts(name, trace, path, player, random);
+  return trace.steps();
+}
+
+
+
+int main(int argc, char **argv){
+  const char *dir = argc > 1 ? argv[1] : "benchmark/data";
+  std::vector<std::vector<int> > hardest, large;
+  if(!load_puzzles(dir, "hardest", 3, hardest) || !load_puzzles(dir, "16x16", 4, large)){
+    fprintf(stderr, "cannot read the puzzle sets in %s\n", dir);
+    return 1;
+  }
+  const std::string path = temp_path("trace_check");
+  std::mt19937 random(1);
+  long longest = 0;
+  char name[64];
+  for(size_t k = 0; k < hardest.size(); ++k){
+    snprintf(name, sizeof(name), "hardest %zu", k + 1);
+    longest = std::max(longest, check_puzzle<3>(name, hardest[k], path.c_str(), random));
+  }
+  for(size_t k = 0; k < large.size(); ++k){
+    snprintf(name, sizeof(name), "16x16 %zu", k + 1);
+    longest = std::max(longest, check_puzzle<4>(name, large[k], path.c_str(), random));
+  }
+  check(longest > sudoku::trace_player::SNAPSHOT_STEPS,
+        "no trace is long enough to need a second snapshot (%ld steps)", longest);
+  remove(path.c_str());
+  return check_status("trace_check");
+}
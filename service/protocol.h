@@ -0,0 +1,281 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+// The wire protocol of the solve service. Both ways a message is a frame: its length in
+// bytes (4 bytes), then that many bytes of payload. All numbers are little-endian.
+//
+// request:  kind (1 byte), engine (1 byte), arg (2 bytes: the count limit of a count or
+//           the clue target of a generate), node budget (8 bytes, 0 for none), time
+//           budget in microseconds (4 bytes, 0 for none), seed of a generate (8 bytes),
+//           then the board of a solve or count in batch line format (see batch.h)
+// response: status (1 byte), kind (1 byte), 0 (2 bytes), value (4 bytes: the solutions
+//           counted or the clues generated), search nodes (8 bytes), time from arrival to
+//           reply in microseconds (4 bytes), then the solution of a solve, the puzzle of
+//           a generate or the counters of a stats request as JSON
+//
+// A connection may send any number of requests without waiting; the responses come back
+// in the order of the requests.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../backtracking_algorithm/result_stream.h"
+
+enum request_kind { REQUEST_SOLVE = 1, REQUEST_COUNT, REQUEST_GENERATE, REQUEST_STATS };
+
+// REQUEST_ENGINE_BITMASK solves with sudoku_solver(), REQUEST_ENGINE_MATRIX with
+// matrix::solve()
+enum request_engine { REQUEST_ENGINE_BITMASK, REQUEST_ENGINE_MATRIX };
+
+enum response_status { RESPONSE_OK, RESPONSE_UNSOLVABLE, RESPONSE_TIMED_OUT, RESPONSE_BAD_REQUEST };
+
+const int REQUEST_HEADER_SIZE = 24;
+const int RESPONSE_HEADER_SIZE = 20;
+// the longest payload either side accepts
+const std::uint32_t MAX_FRAME = 1 << 16;
+
+struct service_request{
+  int kind;
+  int engine;
+  int arg;
+  long max_nodes;
+  long max_micros;
+  std::uint64_t seed;
+  std::string board;
+};
+
+struct service_response{
+  int status;
+  int kind;
+  long value;
+  long nodes;
+  long micros;
+  std::string text;
+};
+
+// where the service listens: a Unix socket at path if it is not empty, otherwise port on
+// the loopback interface
+struct service_address{
+  std::string path;
+  int port;
+};
+
+
+
+// encode_request(request, frame) and encode_response(response, frame) replace frame with
+// the whole frame of the message, length included
+
+// effects: mutates frame
+inline void encode_request(const service_request &request, std::vector<char> &frame){
+  frame.assign(4 + REQUEST_HEADER_SIZE, 0);
+  put_le(&frame[0], REQUEST_HEADER_SIZE + request.board.size(), 4);
+  char *dst = &frame[4];
+  dst[0] = static_cast<char>(request.kind);
+  dst[1] = static_cast<char>(request.engine);
+  put_le(dst + 2, request.arg, 2);
+  put_le(dst + 4, request.max_nodes, 8);
+  put_le(dst + 12, request.max_micros, 4);
+  put_le(dst + 16, request.seed, 8);
+  frame.insert(frame.end(), request.board.begin(), request.board.end());
+}
+
+inline void encode_response(const service_response &response, std::vector<char> &frame){
+  frame.assign(4 + RESPONSE_HEADER_SIZE, 0);
+  put_le(&frame[0], RESPONSE_HEADER_SIZE + response.text.size(), 4);
+  char *dst = &frame[4];
+  dst[0] = static_cast<char>(response.status);
+  dst[1] = static_cast<char>(response.kind);
+  put_le(dst + 4, response.value, 4);
+  put_le(dst + 8, response.nodes, 8);
+  put_le(dst + 16, response.micros < 0xffffffffL ? response.micros : 0xffffffffL, 4);
+  frame.insert(frame.end(), response.text.begin(), response.text.end());
+}
+
+
+
+// decode_request(payload, request) and decode_response(payload, response) read the
+// message in payload (its length left out) and return false if it is too short
+
+// effects: mutates request or response
+inline bool decode_request(const std::vector<char> &payload, service_request &request){
+  if(payload.size() < static_cast<size_t>(REQUEST_HEADER_SIZE)){
+    return false;
+  }
+  const char *src = payload.data();
+  request.kind = static_cast<unsigned char>(src[0]);
+  request.engine = static_cast<unsigned char>(src[1]);
+  request.arg = static_cast<int>(get_le(src + 2, 2));
+  request.max_nodes = static_cast<long>(get_le(src + 4, 8));
+  request.max_micros = static_cast<long>(get_le(src + 12, 4));
+  request.seed = get_le(src + 16, 8);
+  request.board.assign(src + REQUEST_HEADER_SIZE, src + payload.size());
+  return true;
+}
+
+inline bool decode_response(const std::vector<char> &payload, service_response &response){
+  if(payload.size() < static_cast<size_t>(RESPONSE_HEADER_SIZE)){
+    return false;
+  }
+  const char *src = payload.data();
+  response.status = static_cast<unsigned char>(src[0]);
+  response.kind = static_cast<unsigned char>(src[1]);
+  response.value = static_cast<long>(get_le(src + 4, 4));
+  response.nodes = static_cast<long>(get_le(src + 8, 8));
+  response.micros = static_cast<long>(get_le(src + 16, 4));
+  response.text.assign(src + RESPONSE_HEADER_SIZE, src + payload.size());
+  return true;
+}
+
+
+
+// write_all(fd, data, size) writes the size bytes of data to fd, and returns false if the
+// connection fails first
+
+// effects: produces output
+inline bool write_all(int fd, const char *data, size_t size){
+  while(size){
+    const ssize_t done = write(fd, data, size);
+    if(done < 0 && errno == EINTR){
+      continue;
+    }
+    if(done <= 0){
+      return false;
+    }
+    data += done;
+    size -= done;
+  }
+  return true;
+}
+
+// read_all(fd, data, size) reads exactly size bytes from fd into data, and returns false
+// if the connection closes or fails first
+
+// effects: reads input, mutates data
+inline bool read_all(int fd, char *data, size_t size){
+  while(size){
+    const ssize_t done = read(fd, data, size);
+    if(done < 0 && errno == EINTR){
+      continue;
+    }
+    if(done <= 0){
+      return false;
+    }
+    data += done;
+    size -= done;
+  }
+  return true;
+}
+
+// read_frame(fd, payload) reads the next frame from fd into payload, and returns false if
+// the connection closes or the frame is longer than MAX_FRAME
+
+// effects: reads input, mutates payload
+inline bool read_frame(int fd, std::vector<char> &payload){
+  char length[4];
+  if(!read_all(fd, length, 4)){
+    return false;
+  }
+  const std::uint32_t size = static_cast<std::uint32_t>(get_le(length, 4));
+  if(size > MAX_FRAME){
+    return false;
+  }
+  payload.resize(size);
+  return !size || read_all(fd, payload.data(), size);
+}
+
+
+
+// listen_on(address) returns a socket listening at address, or -1 if it cannot be opened
+// (a stale Unix socket file left by an earlier run is replaced)
+
+// effects: may create a file at address.path
+inline int listen_on(const service_address &address){
+  int fd;
+  if(!address.path.empty()){
+    sockaddr_un local;
+    memset(&local, 0, sizeof(local));
+    if(address.path.size() >= sizeof(local.sun_path)){
+      return -1;
+    }
+    local.sun_family = AF_UNIX;
+    memcpy(local.sun_path, address.path.c_str(), address.path.size());
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(address.path.c_str());
+    if(fd < 0 || bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0){
+      if(fd >= 0){
+        close(fd);
+      }
+      return -1;
+    }
+  } else{
+    sockaddr_in local;
+    memset(&local, 0, sizeof(local));
+    local.sin_family = AF_INET;
+    local.sin_port = htons(static_cast<std::uint16_t>(address.port));
+    local.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    const int on = 1;
+    if(fd < 0 || setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) != 0 ||
+       bind(fd, reinterpret_cast<sockaddr *>(&local), sizeof(local)) != 0){
+      if(fd >= 0){
+        close(fd);
+      }
+      return -1;
+    }
+  }
+  if(listen(fd, 128) != 0){
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// connect_to(address) returns a socket connected to the service at address, or -1 if it
+// cannot connect
+inline int connect_to(const service_address &address){
+  int fd;
+  if(!address.path.empty()){
+    sockaddr_un remote;
+    memset(&remote, 0, sizeof(remote));
+    if(address.path.size() >= sizeof(remote.sun_path)){
+      return -1;
+    }
+    remote.sun_family = AF_UNIX;
+    memcpy(remote.sun_path, address.path.c_str(), address.path.size());
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&remote), sizeof(remote)) != 0){
+      if(fd >= 0){
+        close(fd);
+      }
+      return -1;
+    }
+  } else{
+    sockaddr_in remote;
+    memset(&remote, 0, sizeof(remote));
+    remote.sin_family = AF_INET;
+    remote.sin_port = htons(static_cast<std::uint16_t>(address.port));
+    remote.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if(fd < 0 || connect(fd, reinterpret_cast<sockaddr *>(&remote), sizeof(remote)) != 0){
+      if(fd >= 0){
+        close(fd);
+      }
+      return -1;
+    }
+    // requests and responses are small: send them at once
+    const int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+  }
+  return fd;
+}
+
+#endif // PROTOCOL_H
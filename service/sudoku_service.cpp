@@ -0,0 +1,734 @@
+// A long-running solve service, so that a caller with many small puzzles does not pay
+// for starting a process per puzzle. Requests (see protocol.h) arrive over a Unix socket
+// or loopback TCP, read by one thread per connection and answered by another, so that a
+// client slow to read its responses holds up neither the workers nor other clients.
+// Solve, count and generate requests are queued and taken off the queue in
+// micro-batches: the dispatcher waits up to a batch window for enough requests to occupy
+// every idle worker, then hands the batch to the workers, which keep their solver state
+// warm from one request to the next. Workers take the requests handed to them one at a
+// time as they come free, so a slow request holds up only its own worker, never the
+// next batch. Every request runs within its own node and time budget, capped by the
+// service's (one second by default); the time budget counts from the arrival of the
+// request, so one that waited out its budget in the queue is answered as timed out at
+// once.
+//
+// The same program is also a small client: -q sends the puzzles on stdin (or stats or
+// generate requests) to a running service and prints the answers.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <poll.h>
+#include "../Visualizer/backtracking_solver.h"
+#include "../Visualizer/matrix.h"
+#include "../Visualizer/solver.h"
+#include "../backtracking_algorithm/batch.h"
+#include "protocol.h"
+
+typedef std::chrono::steady_clock service_clock;
+
+// the requests of one connection that may be queued, running or waiting to be written
+// at once: past it the service stops reading the connection until its client catches up
+const long OUTBOX_MAX = 1024;
+// the seconds of requests the rate and latency percentiles of a stats request cover
+const int STATS_WINDOW = 10;
+// the time budget in milliseconds a request may have at most, unless -l says otherwise
+const double DEFAULT_MAX_MS = 1000;
+
+// one client connection. Its responses are written by a writer thread of its own, in
+// request order, so that a client slow to read never holds up a worker: a response
+// that is ready waits in done until those ahead of it have been written
+struct connection{
+  int fd;
+  // guards everything below but closed. changed wakes the reader and the writer
+  std::mutex lock;
+  std::condition_variable changed;
+  // the requests read so far, and the sequence number of the next response to write
+  long read;
+  long next_write;
+  std::map<long, std::vector<char> > done;
+  // set once the reader has read the last request
+  bool reading_done;
+  // set once the client has closed its end
+  std::atomic<bool> closed;
+
+  explicit connection(int fd) : fd(fd), read(0), next_write(0), reading_done(false),
+                                closed(false){}
+
+  ~connection(){
+    close(fd);
+  }
+};
+
+// one request on its way through the service
+struct job{
+  std::shared_ptr<connection> conn;
+  long seq;
+  service_request request;
+  service_clock::time_point arrived;
+};
+
+// the solver state a worker keeps between requests
+struct worker_state{
+  sudoku::matrix board;
+  sudoku::generator<3> maker;
+  sudoku::search_stats search;
+  int cells[625];
+  int grid[10][10];
+
+  worker_state() : board(0), maker(0){}
+};
+
+
+
+// latency_stats keeps the arrival-to-reply latencies of the last RING requests, to
+// report the request rate and the latency percentiles over the last STATS_WINDOW seconds
+class latency_stats{
+  public:
+  static const int RING = 1 << 16;
+
+  latency_stats() : started(service_clock::now()), total(0), ring(RING){}
+
+  // record(done, micros) counts a request replied to at done after micros microseconds
+  void record(service_clock::time_point done, long micros){
+    std::lock_guard<std::mutex> hold(lock);
+    ring[total % RING].done = done;
+    ring[total % RING].micros = micros;
+    ++total;
+  }
+
+  // report(queued, running, batches, batched) returns the counters as a JSON object,
+  // with the queue depth, the requests being solved and the batches dispatched so far
+  std::string report(long queued, long running, long batches, long batched){
+    const service_clock::time_point now = service_clock::now();
+    const service_clock::time_point cutoff = now - std::chrono::seconds(STATS_WINDOW);
+    std::vector<long> recent;
+    long all;
+    service_clock::time_point since = cutoff < started ? started : cutoff;
+    {
+      std::lock_guard<std::mutex> hold(lock);
+      all = total;
+      const long kept = total < RING ? total : RING;
+      for(long k = total - kept; k < total; ++k){
+        if(ring[k % RING].done >= cutoff){
+          recent.push_back(ring[k % RING].micros);
+        }
+      }
+      // at high rates the ring holds less than the window
+      if(kept == RING && ring[(total - kept) % RING].done > since){
+        since = ring[(total - kept) % RING].done;
+      }
+    }
+    std::sort(recent.begin(), recent.end());
+    const double span = std::chrono::duration<double>(now - since).count();
+    char text[512];
+    snprintf(text, sizeof(text),
+             "{\"uptime_s\": %.1f, \"requests\": %ld, \"qps\": %.1f, \"p50_us\": %ld, "
+             "\"p99_us\": %ld, \"p999_us\": %ld, \"max_us\": %ld, \"queue_depth\": %ld, "
+             "\"running\": %ld, \"batches\": %ld, \"mean_batch\": %.1f}",
+             std::chrono::duration<double>(now - started).count(), all,
+             span > 0 ? recent.size() / span : 0.0, percentile(recent, 0.5),
+             percentile(recent, 0.99), percentile(recent, 0.999),
+             recent.empty() ? 0 : recent.back(), queued, running, batches,
+             batches ? static_cast<double>(batched) / batches : 0.0);
+    return text;
+  }
+
+
+
+  private:
+  struct sample{
+    service_clock::time_point done;
+    long micros;
+  };
+
+  std::mutex lock;
+  const service_clock::time_point started;
+  long total;
+  std::vector<sample> ring;
+
+  // percentile(sorted, q) returns the q quantile of sorted, or 0 if it is empty
+  static long percentile(const std::vector<long> &sorted, double q){
+    if(sorted.empty()){
+      return 0;
+    }
+    const size_t k = static_cast<size_t>(q * sorted.size());
+    return sorted[k < sorted.size() ? k : sorted.size() - 1];
+  }
+};
+
+
+
+// solve_service queues requests and runs them in micro-batches on its workers (see
+// above)
+class solve_service{
+  public:
+  static const int BATCH_MAX = 256;
+
+  // solve_service(threads, max_nodes, max_micros, window_micros) starts threads workers
+  // that give every request at most max_nodes nodes and max_micros microseconds (each
+  // 0 for no limit), and a dispatcher that waits up to window_micros for a batch to fill
+  solve_service(int threads, long max_nodes, long max_micros, long window_micros) :
+      max_nodes(max_nodes), max_micros(max_micros), window(window_micros), stopping(false),
+      dispatched_all(false), running(0), batches(0), batched(0){
+    for(int id = 0; id < (threads < 1 ? 1 : threads); ++id){
+      states.push_back(new worker_state());
+    }
+    for(size_t id = 0; id < states.size(); ++id){
+      workers.push_back(std::thread(&solve_service::worker_loop, this, states[id]));
+    }
+    dispatcher = std::thread(&solve_service::dispatch_loop, this);
+  }
+
+  // ~solve_service() answers the requests still queued and stops the workers
+  ~solve_service(){
+    {
+      std::lock_guard<std::mutex> hold(lock);
+      stopping = true;
+    }
+    ready.notify_all();
+    dispatcher.join();
+    for(size_t id = 0; id < workers.size(); ++id){
+      workers[id].join();
+      delete states[id];
+    }
+  }
+
+
+
+  // submit(work) queues a solve, count or generate request
+
+  // effects: mutates the queue
+  void submit(const job &work){
+    {
+      std::lock_guard<std::mutex> hold(lock);
+      queue.push_back(work);
+    }
+    ready.notify_one();
+  }
+
+  // reply(work, response) passes response to the writer of the client of work, to send
+  // after every response to the requests it sent before, and counts its latency
+
+  // effects: mutates response and the connection of work
+  void reply(const job &work, service_response &response){
+    const service_clock::time_point now = service_clock::now();
+    response.micros = static_cast<long>(
+        std::chrono::duration_cast<std::chrono::microseconds>(now - work.arrived).count());
+    if(response.kind != REQUEST_STATS){
+      latency.record(now, response.micros);
+    }
+    std::vector<char> frame;
+    encode_response(response, frame);
+    connection &conn = *work.conn;
+    {
+      std::lock_guard<std::mutex> hold(conn.lock);
+      conn.done[work.seq].swap(frame);
+    }
+    conn.changed.notify_all();
+  }
+
+  // stats() returns the live counters as JSON
+  std::string stats(){
+    long queued, busy;
+    long batch_count, batch_total;
+    {
+      std::lock_guard<std::mutex> hold(lock);
+      queued = static_cast<long>(queue.size() + runnable.size());
+      busy = running;
+      batch_count = batches;
+      batch_total = batched;
+    }
+    return latency.report(queued, busy, batch_count, batch_total);
+  }
+
+
+
+  private:
+  const long max_nodes;
+  const long max_micros;
+  const std::chrono::microseconds window;
+  std::vector<worker_state *> states;
+  std::vector<std::thread> workers;
+  std::thread dispatcher;
+  // guards everything below. ready wakes the dispatcher, handed wakes the workers
+  std::mutex lock;
+  std::condition_variable ready;
+  std::condition_variable handed;
+  // the requests not yet batched, and those handed to the workers
+  std::deque<job> queue;
+  std::deque<job> runnable;
+  bool stopping;
+  // set once the dispatcher has handed out every request, after stopping
+  bool dispatched_all;
+  long running;
+  long batches;
+  long batched;
+  latency_stats latency;
+
+  // cap(asked, most) returns the tighter of two limits where 0 means none
+  static long cap(long asked, long most){
+    return !asked ? most : !most ? asked : asked < most ? asked : most;
+  }
+
+
+
+  // idle() returns the workers with nothing to do, at least 1
+
+  // requires: lock must be held
+  size_t idle() const{
+    const size_t busy = static_cast<size_t>(running) + runnable.size();
+    return busy < workers.size() ? workers.size() - busy : 1;
+  }
+
+  // dispatch_loop() takes batches off the queue and hands them to the workers, without
+  // waiting for them to finish, until the service stops and the queue is empty
+  void dispatch_loop(){
+    std::unique_lock<std::mutex> hold(lock);
+    for(;;){
+      ready.wait(hold, [this]{ return stopping || !queue.empty(); });
+      if(queue.empty()){
+        dispatched_all = true;
+        handed.notify_all();
+        return;
+      }
+      if(window.count() > 0 && queue.size() < idle()){
+        ready.wait_for(hold, window, [this]{ return stopping || queue.size() >= idle(); });
+      }
+      const size_t take = queue.size() < static_cast<size_t>(BATCH_MAX) ? queue.size() : BATCH_MAX;
+      runnable.insert(runnable.end(), queue.begin(), queue.begin() + take);
+      queue.erase(queue.begin(), queue.begin() + take);
+      ++batches;
+      batched += take;
+      if(take == 1){
+        handed.notify_one();
+      } else{
+        handed.notify_all();
+      }
+    }
+  }
+
+  // worker_loop(state) serves the requests handed to the workers, one at a time, with
+  // the solver state state until the dispatcher has handed out the last of them
+  void worker_loop(worker_state *state){
+    std::unique_lock<std::mutex> hold(lock);
+    for(;;){
+      handed.wait(hold, [this]{ return dispatched_all || !runnable.empty(); });
+      if(runnable.empty()){
+        return;
+      }
+      const job work = runnable.front();
+      runnable.pop_front();
+      ++running;
+      hold.unlock();
+      serve(work, *state);
+      hold.lock();
+      --running;
+      // a dispatcher waiting out its window may now have enough for the idle workers
+      ready.notify_one();
+    }
+  }
+
+
+
+  // serve(work, state) answers the solve, count or generate request of work with the
+  // solver state of one worker
+
+  // effects: produces output, mutates state
+  void serve(const job &work, worker_state &state){
+    const service_request &request = work.request;
+    service_response response = {RESPONSE_BAD_REQUEST, request.kind, 0, 0, 0, std::string()};
+    sudoku::solve_options options;
+    options.max_nodes = cap(request.max_nodes, max_nodes);
+    const long micros = cap(request.max_micros, max_micros);
+    if(micros){
+      options.deadline = work.arrived + std::chrono::microseconds(micros);
+    }
+    if(request.kind == REQUEST_GENERATE){
+      state.maker.reseed(request.seed);
+      const int clues = state.maker.generate(state.cells, request.arg, sudoku::SYMMETRY_NONE,
+                                             options, &state.search);
+      response.nodes = state.search.nodes;
+      if(clues < 0){
+        response.status = RESPONSE_TIMED_OUT;
+      } else{
+        response.value = clues;
+        response.text.resize(81);
+        format_puzzle(state.cells, 3, &response.text[0]);
+        response.status = RESPONSE_OK;
+      }
+      reply(work, response);
+      return;
+    }
+    if(request.board.size() > 625 || (request.engine != REQUEST_ENGINE_BITMASK &&
+                                      request.engine != REQUEST_ENGINE_MATRIX) ||
+       parse_puzzle(request.board.data(), static_cast<int>(request.board.size()), state.cells) != 3){
+      reply(work, response);
+      return;
+    }
+    for(int cell = 0; cell < 81; ++cell){
+      state.grid[cell / 9][cell % 9] = state.cells[cell];
+    }
+    sudoku::solve_result result;
+    if(request.kind == REQUEST_COUNT){
+      int found;
+      result = count_solutions(state.grid, request.arg > 0 ? request.arg : 2, options,
+                               &state.search, &found);
+      response.value = found;
+    } else if(request.engine == REQUEST_ENGINE_MATRIX){
+      state.board.input(state.grid);
+      result = state.board.solve(options, &state.search);
+      state.board.output(state.grid);
+    } else{
+      result = sudoku_solver(state.grid, options, &state.search);
+    }
+    response.nodes = state.search.nodes;
+    if(result == sudoku::SOLVE_EXHAUSTED){
+      response.status = RESPONSE_TIMED_OUT;
+    } else if(request.kind == REQUEST_COUNT){
+      response.status = RESPONSE_OK;
+    } else if(result == sudoku::SOLVE_UNSOLVABLE){
+      response.status = RESPONSE_UNSOLVABLE;
+    } else{
+      for(int cell = 0; cell < 81; ++cell){
+        state.cells[cell] = state.grid[cell / 9][cell % 9];
+      }
+      response.text.resize(81);
+      format_puzzle(state.cells, 3, &response.text[0]);
+      response.status = RESPONSE_OK;
+    }
+    reply(work, response);
+  }
+};
+
+
+
+// write_responses(conn) writes the responses of conn in request order, until the
+// reader has stopped and every request read has been answered
+
+// effects: produces output, mutates conn
+void write_responses(std::shared_ptr<connection> conn){
+  std::vector<char> frame;
+  bool failed = false;
+  std::unique_lock<std::mutex> hold(conn->lock);
+  for(;;){
+    conn->changed.wait(hold, [&]{
+      return (!conn->done.empty() && conn->done.begin()->first == conn->next_write) ||
+             (conn->reading_done && conn->next_write == conn->read);
+    });
+    if(conn->done.empty() || conn->done.begin()->first != conn->next_write){
+      return;
+    }
+    frame.swap(conn->done.begin()->second);
+    conn->done.erase(conn->done.begin());
+    hold.unlock();
+    // a client that has gone away just misses its responses
+    failed = failed || !write_all(conn->fd, frame.data(), frame.size());
+    hold.lock();
+    ++conn->next_write;
+    // the reader may be waiting for the outbox to shrink
+    conn->changed.notify_all();
+  }
+}
+
+// read_requests(service, conn) reads the requests of conn until it closes, queueing the
+// solve, count and generate requests and answering the others at once. It stops
+// reading while OUTBOX_MAX requests of conn are unanswered or unwritten, and returns
+// once the last response has been written
+
+// effects: reads input, produces output
+void read_requests(solve_service &service, std::shared_ptr<connection> conn){
+  std::thread writer(write_responses, conn);
+  std::vector<char> payload;
+  long seq = 0;
+  while(read_frame(conn->fd, payload)){
+    {
+      std::unique_lock<std::mutex> hold(conn->lock);
+      conn->changed.wait(hold, [&]{ return seq - conn->next_write < OUTBOX_MAX; });
+      conn->read = seq + 1;
+    }
+    job work;
+    work.conn = conn;
+    work.seq = seq++;
+    work.arrived = service_clock::now();
+    const bool decoded = decode_request(payload, work.request);
+    const int kind = decoded ? work.request.kind : 0;
+    if(kind == REQUEST_SOLVE || kind == REQUEST_COUNT || kind == REQUEST_GENERATE){
+      service.submit(work);
+      continue;
+    }
+    service_response response = {RESPONSE_BAD_REQUEST, kind, 0, 0, 0, std::string()};
+    if(kind == REQUEST_STATS){
+      response.status = RESPONSE_OK;
+      response.text = service.stats();
+    }
+    service.reply(work, response);
+  }
+  {
+    std::lock_guard<std::mutex> hold(conn->lock);
+    conn->reading_done = true;
+  }
+  conn->changed.notify_all();
+  writer.join();
+  conn->closed = true;
+}
+
+
+
+volatile sig_atomic_t quit = 0;
+
+void on_signal(int){
+  quit = 1;
+}
+
+// run_server(address, threads, max_nodes, max_micros, window_micros) serves requests at
+// address until SIGINT or SIGTERM (see solve_service). Returns the process exit status
+
+// effects: reads input, produces output
+int run_server(const service_address &address, int threads, long max_nodes, long max_micros,
+               long window_micros){
+  const int listener = listen_on(address);
+  if(listener < 0){
+    fprintf(stderr, "cannot listen on %s\n",
+            address.path.empty() ? "the loopback port" : address.path.c_str());
+    return 1;
+  }
+  signal(SIGPIPE, SIG_IGN);
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  solve_service service(threads, max_nodes, max_micros, window_micros);
+  std::vector<std::thread> readers;
+  std::vector<std::shared_ptr<connection> > conns;
+  if(address.path.empty()){
+    fprintf(stderr, "listening on 127.0.0.1:%d\n", address.port);
+  } else{
+    fprintf(stderr, "listening on %s\n", address.path.c_str());
+  }
+
+  while(!quit){
+    pollfd waiting = {listener, POLLIN, 0};
+    if(poll(&waiting, 1, 200) > 0){
+      const int fd = accept(listener, NULL, NULL);
+      if(fd >= 0){
+        if(address.path.empty()){
+          const int on = 1;
+          setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        }
+        conns.push_back(std::make_shared<connection>(fd));
+        readers.push_back(std::thread(read_requests, std::ref(service), conns.back()));
+      }
+    }
+    // let go of the connections that have closed
+    for(size_t k = 0; k < conns.size(); ){
+      if(conns[k]->closed){
+        readers[k].join();
+        readers.erase(readers.begin() + k);
+        conns.erase(conns.begin() + k);
+      } else{
+        ++k;
+      }
+    }
+  }
+
+  close(listener);
+  if(!address.path.empty()){
+    unlink(address.path.c_str());
+  }
+  for(size_t k = 0; k < conns.size(); ++k){
+    shutdown(conns[k]->fd, SHUT_RDWR);
+    readers[k].join();
+  }
+  return 0;
+}
+
+
+
+// print_response(request, response) prints one answer on stdout: for a solve the
+// solution (or the puzzle if it has none) followed by the status, the nodes and the
+// microseconds, for a count the same with the solutions counted in place of the board,
+// and for a generate the puzzle (- if there is none), the status, its clues and the
+// microseconds
+
+// effects: produces output
+void print_response(const service_request &request, const service_response &response){
+  const char *names[] = {"ok", "unsolvable", "timeout", "bad_request"};
+  const char *status = response.status <= RESPONSE_BAD_REQUEST ? names[response.status] : "unknown";
+  if(request.kind == REQUEST_STATS){
+    printf("%s\n", response.text.c_str());
+  } else if(request.kind == REQUEST_COUNT){
+    printf("%ld %s %ld %ld\n", response.value, status, response.nodes, response.micros);
+  } else if(request.kind == REQUEST_GENERATE){
+    printf("%s %s %ld %ld\n", response.status == RESPONSE_OK ? response.text.c_str() : "-",
+           status, response.value, response.micros);
+  } else{
+    printf("%s %s %ld %ld\n", response.status == RESPONSE_OK ? response.text.c_str() : request.board.c_str(),
+           status, response.nodes, response.micros);
+  }
+}
+
+
+
+// run_client(address, request, count) sends requests like request to the service at
+// address and prints the answers in order: one per line of stdin for a solve or count
+// (the line as the board), count with seeds request.seed, request.seed + 1, ... for a
+// generate, or one for stats. Up to WINDOW requests are in flight at once. Returns the
+// process exit status
+
+// effects: reads input, produces output
+int run_client(const service_address &address, service_request request, long count){
+  const size_t WINDOW = 64;
+  const int fd = connect_to(address);
+  if(fd < 0){
+    fprintf(stderr, "cannot connect to %s\n",
+            address.path.empty() ? "the loopback port" : address.path.c_str());
+    return 1;
+  }
+  std::deque<service_request> pending;
+  std::vector<char> frame;
+  service_response response;
+  char line[4096];
+  long sent = 0;
+  const service_clock::time_point start = service_clock::now();
+  for(bool more = true; more || !pending.empty(); ){
+    if(more && pending.size() < WINDOW){
+      if(request.kind == REQUEST_SOLVE || request.kind == REQUEST_COUNT){
+        more = fgets(line, sizeof(line), stdin) != NULL;
+        if(more){
+          request.board.assign(line, strcspn(line, "\r\n"));
+          if(request.board.empty()){
+            continue;
+          }
+        }
+      } else{
+        more = sent < count;
+      }
+      if(more){
+        encode_request(request, frame);
+        if(!write_all(fd, frame.data(), frame.size())){
+          break;
+        }
+        pending.push_back(request);
+        ++sent;
+        ++request.seed;
+        continue;
+      }
+    }
+    if(pending.empty()){
+      break;
+    }
+    if(!read_frame(fd, frame) || !decode_response(frame, response)){
+      fprintf(stderr, "the service closed the connection\n");
+      close(fd);
+      return 1;
+    }
+    print_response(pending.front(), response);
+    pending.pop_front();
+  }
+  close(fd);
+  const double seconds = std::chrono::duration<double>(service_clock::now() - start).count();
+  if(request.kind != REQUEST_STATS){
+    fprintf(stderr, "%ld requests in %.3f s, %.0f requests/s\n", sent, seconds,
+            seconds > 0 ? sent / seconds : 0.0);
+  }
+  return 0;
+}
+
+
+
+void print_usage(const char *name){
+  fprintf(stderr,
+          "usage: %s [-u path | -p port] [-t n] [-n nodes] [-l ms] [-m us]\n"
+          "                                 serve solve, count and generate requests on the\n"
+          "                                 Unix socket path (default /tmp/sudoku-service.sock)\n"
+          "                                 or on loopback TCP port, with n workers (default:\n"
+          "                                 one per core), giving each request at most -n nodes\n"
+          "                                 and -l milliseconds (default 1000, 0 for no limit),\n"
+          "                                 and waiting up to -m microseconds (default 100)\n"
+          "                                 for a batch to fill\n"
+          "       %s -q solve|count|generate|stats [-u path | -p port] [-e bitmask|matrix]\n"
+          "          [-n nodes] [-l ms] [-k limit] [-c clues] [-s seed] [-g n]\n"
+          "                                 send a solve or count request for every puzzle\n"
+          "                                 line on stdin (counting up to -k solutions), n\n"
+          "                                 generate requests or a stats request to the\n"
+          "                                 service and print the answers\n",
+          name, name);
+}
+
+
+
+int main(int argc, char **argv){
+  service_address address = {"/tmp/sudoku-service.sock", 0};
+  const int cores = std::thread::hardware_concurrency();
+  int threads = cores > 0 ? cores : 1;
+  long max_nodes = 0;
+  // below 0 until -l: the service then caps requests at DEFAULT_MAX_MS, and a client
+  // leaves the budget to the service
+  double max_ms = -1;
+  long window = 100;
+  const char *query = NULL;
+  service_request request = {REQUEST_SOLVE, REQUEST_ENGINE_BITMASK, 0, 0, 0, 1, std::string()};
+  long count = 1;
+  bool valid = true;
+  for(int k = 1; k < argc; ++k){
+    if(strcmp(argv[k], "-u") == 0 && k + 1 < argc){
+      address.path = argv[++k];
+    } else if(strcmp(argv[k], "-p") == 0 && k + 1 < argc){
+      address.path.clear();
+      address.port = atoi(argv[++k]);
+    } else if(strcmp(argv[k], "-t") == 0 && k + 1 < argc){
+      threads = atoi(argv[++k]);
+    } else if(strcmp(argv[k], "-n") == 0 && k + 1 < argc){
+      max_nodes = atol(argv[++k]);
+    } else if(strcmp(argv[k], "-l") == 0 && k + 1 < argc){
+      max_ms = atof(argv[++k]);
+    } else if(strcmp(argv[k], "-m") == 0 && k + 1 < argc){
+      window = atol(argv[++k]);
+    } else if(strcmp(argv[k], "-q") == 0 && k + 1 < argc){
+      query = argv[++k];
+    } else if(strcmp(argv[k], "-e") == 0 && k + 1 < argc){
+      ++k;
+      valid = valid && (strcmp(argv[k], "bitmask") == 0 || strcmp(argv[k], "matrix") == 0);
+      request.engine = strcmp(argv[k], "matrix") == 0 ? REQUEST_ENGINE_MATRIX : REQUEST_ENGINE_BITMASK;
+    } else if((strcmp(argv[k], "-k") == 0 || strcmp(argv[k], "-c") == 0) && k + 1 < argc){
+      request.arg = atoi(argv[++k]);
+    } else if(strcmp(argv[k], "-s") == 0 && k + 1 < argc){
+      request.seed = strtoull(argv[++k], NULL, 10);
+    } else if(strcmp(argv[k], "-g") == 0 && k + 1 < argc){
+      count = atol(argv[++k]);
+    } else{
+      valid = false;
+      break;
+    }
+  }
+  valid = valid && threads >= 1 && max_nodes >= 0 && (max_ms >= 0 || max_ms == -1) && window >= 0 &&
+          (!address.path.empty() || (address.port > 0 && address.port < 65536)) &&
+          request.arg >= 0 && request.arg < 65536;
+  if(valid && !query){
+    const long max_micros = static_cast<long>((max_ms < 0 ? DEFAULT_MAX_MS : max_ms) * 1000);
+    return run_server(address, threads, max_nodes, max_micros, window);
+  }
+  const long max_micros = max_ms < 0 ? 0 : static_cast<long>(max_ms * 1000);
+  const char *kinds[] = {"solve", "count", "generate", "stats"};
+  for(int kind = 0; valid && query && kind < 4; ++kind){
+    if(strcmp(query, kinds[kind]) == 0){
+      request.kind = REQUEST_SOLVE + kind;
+      request.max_nodes = max_nodes;
+      request.max_micros = max_micros;
+      return run_client(address, request, request.kind == REQUEST_GENERATE ? count : 1);
+    }
+  }
+  print_usage(argv[0]);
+  return 2;
+}